@@ -0,0 +1,329 @@
+       
+       /************************************************************
+        * @file   bst-map-bench.cpp
+        * @author Evan Gray
+        *
+        * @brief: Benchmarks BSTmap and BSTflatmap against std::map
+        *         and std::unordered_map, reporting time per op,
+        *         allocations, heap bytes per entry, tree height and
+        *         peak RSS for int and string keys
+        *
+        *         Usage: bst-map-bench [max size, 1000 to 10000000]
+       *************************************************************/
+       #include "bst-map.h"
+       #include &ltalgorithm>
+       #include &ltatomic>
+       #include &ltchrono>
+       #include &ltcstdio>
+       #include &ltcstdlib>
+       #include &ltmap>
+       #include &ltnew>
+       #include &ltrandom>
+       #include &ltstring>
+       #include &ltunordered_map>
+       #include &ltvector>
+       
+       #ifdef _WIN32
+         #define NOMINMAX
+         #include &ltwindows.h>
+         #include &ltpsapi.h>
+       #else
+         #include &ltsys/resource.h>
+         #include &ltsys/wait.h>
+         #include &ltunistd.h>
+       #endif
+       
+       //Heap traffic of every container, counted in the global operator new
+       static std::atomic&ltunsigned long long> sAllocations{ 0 };
+       static std::atomic&ltunsigned long long> sAllocatedBytes{ 0 };
+       
+       //Sorted inserts turn the unbalanced tree into a list (O(n^2) total), so larger runs are skipped
+       static const int sUnbalancedLimit = 10000;
+       
+       /************************************************************
+        * @brief: Counts every heap allocation so containers can be
+        *         compared by allocation count and bytes per entry
+       *************************************************************/
+       void* operator new(std::size_t size)
+       {
+         sAllocations.fetch_add(1, std::memory_order_relaxed);
+         sAllocatedBytes.fetch_add(size, std::memory_order_relaxed);
+         if(void* memory = std::malloc(size ? size : 1))
+         {
+           return memory;
+         }
+         throw std::bad_alloc();
+       }
+       
+       void operator delete(void* memory) noexcept
+       {
+         std::free(memory);
+       }
+       
+       void operator delete(void* memory, std::size_t) noexcept
+       {
+         std::free(memory);
+       }
+       
+       /************************************************************
+        * @brief: Gets the peak resident set size of this process
+        *
+        * @return double: Peak RSS in megabytes
+       *************************************************************/
+       static double PeakRSS()
+       {
+       #ifdef _WIN32
+         PROCESS_MEMORY_COUNTERS counters{};
+         GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters));
+         return counters.PeakWorkingSetSize / (1024.0 * 1024.0);
+       #else
+         rusage usage{};
+         getrusage(RUSAGE_SELF, &usage);
+         #ifdef __APPLE__
+           return usage.ru_maxrss / (1024.0 * 1024.0);
+         #else
+           return usage.ru_maxrss / 1024.0;
+         #endif
+       #endif
+       }
+       
+       //Makes the key for passed index, strings are long enough to skip the small string buffer
+       template&lttypename KEY> KEY MakeKey(int index);
+       template&lt> int MakeKey&ltint>(int index) { return index; }
+       template&lt> std::string MakeKey&ltstd::string>(int index) { return "benchmark-key-" + std::to_string(index); }
+       
+       /************************************************************
+        * @brief: Adapters giving every container the same insert,
+        *         find, erase and iterate calls
+       *************************************************************/
+       template&lttypename KEY>
+       struct StdMapBench
+       {
+         static const char* Name() { return "std::map"; }
+         static const bool Balanced = true;
+         void Insert(KEY const& key) { map[key] = 1; }
+         bool Find(KEY const& key) { return map.find(key) != map.end(); }
+         void Erase(KEY const& key) { map.erase(key); }
+         long long Iterate() { long long sum = 0; for(auto& entry : map) { sum += entry.second; } return sum; }
+         void Finish() {}
+         unsigned int Height() { return 0; }
+         std::map&ltKEY, int> map;
+       };
+       
+       template&lttypename KEY>
+       struct StdUnorderedBench
+       {
+         static const char* Name() { return "std::unordered_map"; }
+         static const bool Balanced = true;
+         void Insert(KEY const& key) { map[key] = 1; }
+         bool Find(KEY const& key) { return map.find(key) != map.end(); }
+         void Erase(KEY const& key) { map.erase(key); }
+         long long Iterate() { long long sum = 0; for(auto& entry : map) { sum += entry.second; } return sum; }
+         void Finish() {}
+         unsigned int Height() { return 0; }
+         std::unordered_map&ltKEY, int> map;
+       };
+       
+       template&lttypename KEY>
+       struct BSTmapBench
+       {
+         static const char* Name() { return "CS280::BSTmap"; }
+         static const bool Balanced = false;
+         void Insert(KEY const& key) { map[key] = 1; }
+         bool Find(KEY const& key) { return map.find(key) != map.end(); }
+         void Erase(KEY const& key) { auto it = map.find(key); if(it != map.end()) { map.erase(it); } }
+         long long Iterate() { long long sum = 0; for(auto it = reader.begin(); it != reader.end(); ++it) { sum += it->Value(); } return sum; }
+         void Finish() {}
+         unsigned int Height() { return map.height(); }
+         CS280::BSTmap&ltKEY, int> map;
+         const CS280::BSTmap&ltKEY, int>& reader = map;
+       };
+       
+       //Flat map inserts are O(n), so it is built the way it is meant to be, through BSTmap::freeze
+       template&lttypename KEY>
+       struct BSTflatmapBench
+       {
+         static const char* Name() { return "CS280::BSTflatmap"; }
+         static const bool Balanced = false;
+         void Insert(KEY const& key) { staging[key] = 1; }
+         bool Find(KEY const& key) { return map.find(key) != map.end(); }
+         void Erase(KEY const& key) { auto it = map.find(key); if(it != map.end()) { map.erase(it); } }
+         long long Iterate() { long long sum = 0; for(auto it = map.begin(); it != map.end(); ++it) { sum += it->Value(); } return sum; }
+         void Finish() { map = staging.freeze(); staging = CS280::BSTmap&ltKEY, int>(); }
+         unsigned int Height() { return 0; }
+         CS280::BSTmap&ltKEY, int> staging;
+         CS280::BSTflatmap&ltKEY, int> map;
+       };
+       
+       /************************************************************
+        * @brief: Times passed function
+        *
+        * @param function: Work to time
+        * @param ops: Number of operations the work does
+        * @return double: Nanoseconds per operation
+       *************************************************************/
+       template&lttypename FUNCTION>
+       static double Time(FUNCTION function, size_t ops)
+       {
+         auto start = std::chrono::steady_clock::now();
+         function();
+         auto end = std::chrono::steady_clock::now();
+         return std::chrono::duration&ltdouble, std::nano>(end - start).count() / (ops ? ops : 1);
+       }
+       
+       /************************************************************
+        * @brief: Fills a fresh container with keys in passed order
+        *
+        * @param keys: Keys to insert
+        * @return double: Nanoseconds per insert
+       *************************************************************/
+       template&lttemplate&lttypename> class BENCH, typename KEY>
+       static double TimeOrderedInsert(std::vector&ltKEY> const& keys)
+       {
+         BENCH&ltKEY> bench;
+         return Time([&]() { for(KEY const& key : keys) { bench.Insert(key); } bench.Finish(); }, keys.size());
+       }
+       
+       /************************************************************
+        * @brief: Runs every workload on one container and prints a
+        *         row of results
+        *
+        * @param size: Number of entries
+        * @param churn: If the erase heavy workload can run (flat
+        *               maps erase in O(n))
+       *************************************************************/
+       template&lttemplate&lttypename> class BENCH, typename KEY>
+       static void RunBench(int size, bool churn)
+       {
+         //Keys in random order, plus keys that are never inserted for misses
+         std::mt19937 random(size);
+         std::vector&ltKEY> keys, missing, sorted, reversed;
+         for(int i = 0; i &lt size; ++i)
+         {
+           keys.push_back(MakeKey&ltKEY>(2 * i));
+           missing.push_back(MakeKey&ltKEY>(2 * i + 1));
+         }
+         sorted = keys;
+         std::sort(sorted.begin(), sorted.end());
+         reversed.assign(sorted.rbegin(), sorted.rend());
+         std::shuffle(keys.begin(), keys.end(), random);
+         std::shuffle(missing.begin(), missing.end(), random);
+       
+         //Random insert, counting heap traffic
+         BENCH&ltKEY> bench;
+         unsigned long long allocations = sAllocations.load();
+         unsigned long long bytes = sAllocatedBytes.load();
+         double insert = Time([&]() { for(KEY const& key : keys) { bench.Insert(key); } bench.Finish(); }, size);
+         allocations = sAllocations.load() - allocations;
+         bytes = sAllocatedBytes.load() - bytes;
+       
+         //Lookups
+         size_t found = 0;
+         double hit = Time([&]() { for(KEY const& key : keys) { found += bench.Find(key); } }, size);
+         double miss = Time([&]() { for(KEY const& key : missing) { found += bench.Find(key); } }, size);
+         long long sum = 0;
+         double iterate = Time([&]() { sum = bench.Iterate(); }, size);
+         unsigned int height = bench.Height();
+       
+         //Erase heavy churn, each op erases a present key and inserts a new one
+         double erase = -1;
+         if(churn)
+         {
+           erase = Time([&]()
+           {
+             for(int i = 0; i &lt size; ++i)
+             {
+               bench.Erase(keys[i]);
+               bench.Insert(missing[i]);
+             }
+           }, size);
+         }
+       
+         //Sorted and reverse inserts, only where they finish
+         double sortedInsert = -1, reversedInsert = -1;
+         if(BENCH&ltKEY>::Balanced || size &lt= sUnbalancedLimit)
+         {
+           sortedInsert = TimeOrderedInsert&ltBENCH>(sorted);
+           reversedInsert = TimeOrderedInsert&ltBENCH>(reversed);
+         }
+       
+         //Results are used, so the work cant be optimized away
+         if(found != static_cast&ltsize_t>(size) || sum != size)
+         {
+           std::printf("  %s returned wrong results\n", BENCH&ltKEY>::Name());
+         }
+       
+         std::printf("  %-19s %8.1f %8.1f %8.1f %8.1f %8.1f %8.1f %8.1f %10.2f %9.1f %7u %9.1f\n",
+                     BENCH&ltKEY>::Name(), insert, sortedInsert, reversedInsert, hit, miss, iterate, erase,
+                     static_cast&ltdouble>(allocations) / size, static_cast&ltdouble>(bytes) / size, height, PeakRSS());
+         std::fflush(stdout);
+       }
+       
+       /************************************************************
+        * @brief: Runs one container's benchmark in its own process
+        *         so its peak RSS is not hidden by an earlier, larger
+        *         run (Windows runs in process, so RSS only grows)
+        *
+        * @param size: Number of entries
+        * @param churn: If the erase heavy workload can run
+       *************************************************************/
+       template&lttemplate&lttypename> class BENCH, typename KEY>
+       static void RunIsolated(int size, bool churn)
+       {
+       #ifdef _WIN32
+         RunBench&ltBENCH, KEY>(size, churn);
+       #else
+         //Anything still buffered would be printed again by the child
+         std::fflush(stdout);
+         pid_t child = fork();
+         if(child == 0)
+         {
+           RunBench&ltBENCH, KEY>(size, churn);
+           _exit(0);
+         }
+         int status = 0;
+         waitpid(child, &status, 0);
+       #endif
+       }
+       
+       /************************************************************
+        * @brief: Runs every container for one key type at sizes
+        *         from 10^3 up to maxSize
+        *
+        * @param keyName: Name of the key type to print
+        * @param maxSize: Largest size to run
+       *************************************************************/
+       template&lttypename KEY>
+       static void RunKeyType(const char* keyName, int maxSize)
+       {
+         for(int size = 1000; size &lt= maxSize; size *= 10)
+         {
+           std::printf("\n%s keys, n = %d (ns per op, -1 = skipped, height 0 = not a tree)\n", keyName, size);
+           std::printf("  %-19s %8s %8s %8s %8s %8s %8s %8s %10s %9s %7s %9s\n", "container", "insert", "sorted",
+                       "reverse", "hit", "miss", "iterate", "churn", "allocs/n", "bytes/n", "height", "peak MB");
+           RunIsolated&ltStdMapBench, KEY>(size, true);
+           RunIsolated&ltStdUnorderedBench, KEY>(size, true);
+           RunIsolated&ltBSTmapBench, KEY>(size, true);
+           RunIsolated&ltBSTflatmapBench, KEY>(size, false);
+         }
+       }
+       
+       /************************************************************
+        * @brief: Runs the benchmark
+        *
+        * @param argc: Number of arguments
+        * @param argv: Arguments, the first is the max size
+        * @return int: Exit code
+       *************************************************************/
+       int main(int argc, char** argv)
+       {
+         //Largest size defaults to 10^6, 10^7 takes minutes and gigabytes
+         int maxSize = (argc > 1) ? std::atoi(argv[1]) : 1000000;
+         maxSize = std::min(std::max(maxSize, 1000), 10000000);
+       
+         std::printf("BSTmap node: %u bytes (int keys), %u bytes (string keys)\n",
+                     CS280::BSTmap&ltint, int>::bytesPerNode(), CS280::BSTmap&ltstd::string, int>::bytesPerNode());
+         RunKeyType&ltint>("int", maxSize);
+         RunKeyType&ltstd::string>("string", maxSize);
+         return 0;
+       }
\ No newline at end of file
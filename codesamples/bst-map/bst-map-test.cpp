@@ -0,0 +1,234 @@
+       
+       /************************************************************
+        * @file   bst-map-test.cpp
+        * @author Evan Gray
+        *
+        * @brief: Tests for BSTmap snapshots, checks that writes to
+        *         the live map never show up in a snapshot
+       *************************************************************/
+       #include "bst-map.h"
+       #include &ltcstdio>
+       
+       //Counts failed checks
+       static int failures = 0;
+       
+       //Reports a failed check without stopping the other tests
+       #define CHECK(condition) \
+         if(!(condition)) { std::printf("FAILED %s:%d: %s\n", __FILE__, __LINE__, #condition); ++failures; }
+       
+       //Map type used by every test
+       typedef CS280::BSTmap&ltint, int> Map;
+       
+       /************************************************************
+        * @brief: Fills passed map with keys in an order that makes
+        *         a tree with both branches used
+        *
+        * @param map: Map to fill
+        * @param count: Number of keys to add (value is key * 10)
+       *************************************************************/
+       static void fill(Map& map, int count)
+       {
+         for(int i = 0; i &lt count; ++i)
+         {
+           int key = (i * 7919) % count;
+           map[key] = key * 10;
+         }
+       }
+       
+       /************************************************************
+        * @brief: Checks passed map holds exactly keys 0 to count-1
+        *         in order with their original values
+        *
+        * @param map: Map to check
+        * @param count: Number of keys it should hold
+        * @return true: Map is intact
+       *************************************************************/
+       static bool intact(const Map& map, int count)
+       {
+         int expected = 0;
+         for(Map::BSTmap_iterator_const it = map.begin(); it != map.end(); ++it, ++expected)
+         {
+           if(it->Key() != expected || it->Value() != expected * 10)
+           {
+             return false;
+           }
+         }
+         return expected == count && map.size() == static_cast&ltunsigned int>(count);
+       }
+       
+       /************************************************************
+        * @brief: Erasing through an iterator taken before a snapshot
+        *         must not touch the snapshot's nodes
+       *************************************************************/
+       static void testEraseAfterSnapshot()
+       {
+         Map live;
+         fill(live, 100);
+       
+         //Iterators to a leaf, a one branch node and the root (two branches)
+         Map::BSTmap_iterator leaf = live.find(99);
+         Map::BSTmap_iterator root = live.begin();
+         while(root->Key() != 0)
+         {
+           ++root;
+         }
+         Map snapshot = live.snapshot();
+       
+         live.erase(leaf);
+         live.erase(root);
+         live.erase(live.find(50));
+       
+         CHECK(intact(snapshot, 100));
+         CHECK(live.size() == 97);
+         CHECK(live.find(99) == live.end());
+         CHECK(live.find(50) == live.end());
+         CHECK(live.find(0) == live.end());
+       }
+       
+       /************************************************************
+        * @brief: Writing a value through an iterator taken before a
+        *         snapshot must not change the snapshot
+       *************************************************************/
+       static void testWriteAfterSnapshot()
+       {
+         Map live;
+         fill(live, 100);
+       
+         Map::BSTmap_iterator it = live.find(42);
+         Map snapshot = live.snapshot();
+         it->Value() = -1;
+         live[7] = -7;
+       
+         CHECK(intact(snapshot, 100));
+         CHECK(live.find(42)->Value() == -1);
+         CHECK(live.find(7)->Value() == -7);
+       }
+       
+       /************************************************************
+        * @brief: An iterator that already wrote once must still
+        *         write its own node after a later write copied the
+        *         nodes on its path
+       *************************************************************/
+       static void testStalePath()
+       {
+         Map live;
+         live[2] = 20;
+         live[1] = 10;
+         live[3] = 30;
+       
+         //begin() knows its path (2, 1) once it has written
+         Map::BSTmap_iterator it = live.begin();
+         it->Value() = 11;
+         Map snapshot = live.snapshot();
+         live[1] = 12;
+         it->Value() = 13;
+       
+         CHECK(live.find(1)->Value() == 13);
+         CHECK(live.find(3)->Value() == 30);
+         CHECK(snapshot.find(1)->Value() == 11);
+       
+         //Same with nothing on the other side, the old path would follow a NULL branch
+         Map lopsided;
+         lopsided[2] = 20;
+         lopsided[1] = 10;
+         Map::BSTmap_iterator first = lopsided.begin();
+         first->Value() = 11;
+         Map copy = lopsided.snapshot();
+         lopsided[1] = 12;
+         first->Value() = 13;
+       
+         CHECK(lopsided.find(1)->Value() == 13);
+         CHECK(copy.find(1)->Value() == 11);
+       }
+       
+       /************************************************************
+        * @brief: A write after a snapshot copies only the path from
+        *         the root and reads copy nothing
+       *************************************************************/
+       static void testPathCopy()
+       {
+         Map live;
+         fill(live, 1000);
+         Map snapshot = live.snapshot();
+       
+         //Reads through non const iterators share everything
+         unsigned long long before = Map::allocations();
+         int sum = 0;
+         for(Map::BSTmap_iterator it = live.begin(); it != live.end(); ++it)
+         {
+           sum += it->Key();
+         }
+         live.find(500);
+         CHECK(sum == 999 * 1000 / 2);
+         CHECK(Map::allocations() == before);
+       
+         //One write copies at most one node per level
+         live[500] = 0;
+         CHECK(Map::allocations() - before &lt= live.height());
+         CHECK(intact(snapshot, 1000));
+       }
+       
+       /************************************************************
+        * @brief: Snapshots outliving the map and the map outliving
+        *         snapshots both free every node exactly once
+       *************************************************************/
+       static void testLifetimes()
+       {
+         unsigned long long live = Map::liveNodes();
+         {
+           Map* map = new Map;
+           fill(*map, 100);
+           Map first = map->snapshot();
+           (*map)[5] = 0;
+           Map second = map->snapshot();
+           delete map;
+           CHECK(intact(first, 100));
+           second = first;
+           map = new Map(second);
+           map->erase(map->find(3));
+           CHECK(intact(second, 100));
+           delete map;
+         }
+         CHECK(Map::liveNodes() == live);
+       }
+       
+       /************************************************************
+        * @brief: A frozen map can be read through a const reference
+        *         the same way a BSTmap can
+       *************************************************************/
+       static void testFrozenConst()
+       {
+         Map live;
+         fill(live, 100);
+         const CS280::BSTflatmap&ltint, int> flat = live.freeze();
+       
+         int expected = 0;
+         for(CS280::BSTflatmap&ltint, int>::BSTflatmap_iterator_const it = flat.begin(); it != flat.end(); ++it, ++expected)
+         {
+           CHECK(it->Key() == expected && it->Value() == expected * 10);
+         }
+         CHECK(flat.size() == 100);
+         CHECK(flat.find(42)->Value() == 420);
+         CHECK(flat.find(100) == flat.end());
+       }
+       
+       /************************************************************
+        * @brief: Runs every test
+        *
+        * @return int: Number of failed checks
+       *************************************************************/
+       int main()
+       {
+         testEraseAfterSnapshot();
+         testWriteAfterSnapshot();
+         testStalePath();
+         testPathCopy();
+         testLifetimes();
+         testFrozenConst();
+       
+         if(failures == 0)
+         {
+           std::printf("All tests passed\n");
+         }
+         return failures;
+       }
\ No newline at end of file
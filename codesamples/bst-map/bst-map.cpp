@@ -6,6 +6,7 @@
         * @brief: Implemetation of a binary search tree map
        *************************************************************/
        #include "bst-map.h"
+       #include &ltatomic>
        
        //Macros to reduce repeated code
        #define BST BSTmap&ltKEY_TYPE, VALUE_TYPE>
@@ -13,6 +14,14 @@
        #define BSTN BST::Node
        #define tyBST typename BST
        #define tyBSTI typename BSTI
+       #define BSTIC BST::BSTmap_iterator_const
+       #define tyBSTIC typename BSTIC
+       #define FLAT BSTflatmap&ltKEY_TYPE, VALUE_TYPE>
+       #define FLATI FLAT::BSTflatmap_iterator
+       #define tyFLAT typename FLAT
+       #define tyFLATI typename FLATI
+       #define FLATIC FLAT::BSTflatmap_iterator_const
+       #define tyFLATIC typename FLATIC
        
        namespace CS280 
        {
@@ -23,21 +32,28 @@
          template&lttypename KEY_TYPE, typename VALUE_TYPE>
          tyBST::BSTmap_iterator_const BST::const_end_it = BST::BSTmap_iterator_const(nullptr);
        
+         //Counters are shared by every map of a type, so maps on other threads can bump them too
+         template&lttypename KEY_TYPE, typename VALUE_TYPE>
+         std::atomic&ltunsigned long long> BST::allocationCount{ 0 };
+       
+         template&lttypename KEY_TYPE, typename VALUE_TYPE>
+         std::atomic&ltunsigned long long> BST::freeCount{ 0 };
+       
          //--------------------------------------------------------------------------------------
          //Node functions------------------------------------------------------------------------
          //--------------------------------------------------------------------------------------
          /************************************************************
-          * @brief: Construct a new Node
+          * @brief: Construct a new Node, owned by one parent (or 
+          *         map root) to start
           * 
           * @param k: key 
           * @param val: value
-          * @param p: parent node pointer
           * @param l: left node pointer
           * @param r: right node pointer
          *************************************************************/
          template&lttypename KEY_TYPE, typename VALUE_TYPE> 
-         BSTN::Node(KEY_TYPE k, VALUE_TYPE val, Node* p, Node* l, Node* r)
-           : key(k), value(val), parent(p), left(l), right(r)
+         BSTN::Node(KEY_TYPE k, VALUE_TYPE val, Node* l, Node* r)
+           : key(k), value(val), left(l), right(r), refs(1)
          {}
        
          /************************************************************
@@ -62,121 +78,21 @@
            return this->value;
          }
        
-         /************************************************************
-          * @brief: Gets the first node of this node by branching as
-          *         far left as possible in this node
-          *      
-          * @return tyBST::Node*: First node
-         *************************************************************/
-         template&lttypename KEY_TYPE, typename VALUE_TYPE>
-         tyBST::Node* BSTN::first()
-         {
-           //If this is as far left as possible
-           if(this->left == NULL)
-           {
-             return this;
-           }
-       
-           //Get first of left
-           return this->left->first();
-         }
-       
-         /************************************************************
-          * @brief: Gets the last node of this node by branching as
-          *         far right as possible in this node
-          *               
-          * @return tyBST::Node*: Last node
-         *************************************************************/
-         template&lttypename KEY_TYPE, typename VALUE_TYPE>
-         tyBST::Node* BSTN::last()
-         {
-           //If this is as far right as possible
-           if(this->right == NULL)
-           {
-             return this;
-           }
-       
-           //Get last of right
-           return this->right->last();
-         }
-       
-         /************************************************************
-          * @brief: Go one node forward, as in to the node with the
-          *         closest greater key
-          *             
-          * @return tyBST::Node*: One node forward from passed node
-         *************************************************************/
-         template&lttypename KEY_TYPE, typename VALUE_TYPE>
-         tyBST::Node* BSTN::increment()
-         {
-           //Go right if possible since always larger
-           if(this->right != NULL)
-           {
-             //Get first of the right side
-             return this->right->first();
-           }
-       
-           //Go to parent if it exists
-           if(this->parent != NULL)
-           {
-             //Loop up through all parents in tell larger
-             Node* current = this->parent;
-             while (current != NULL && current->key &lt this->key)
-             {
-               current = current->parent; 
-             }
-       
-             return current;
-           }
-       
-           //Return NULL if no option found
-           return NULL;
-         }
-       
-         /************************************************************
-          * @brief: Go one node backwards, as in to the node with the
-          *         closest lesser key
-          *        
-          * @return tyBST::Node*: One node backwards from passed node
-         *************************************************************/
-         template&lttypename KEY_TYPE, typename VALUE_TYPE>
-         tyBST::Node* BSTN::decrement()
-         {
-           //Go left if possible since always smaller
-           if(this->left != NULL)
-           {
-             //Loop down through all rights for the left
-             return this->left->last();
-           }
-       
-           //Go to parent if it exists
-           if(this->parent != NULL)
-           {
-             //Loop up through all parents in tell smaller
-             Node* current = this->parent;
-             while (current != NULL && current->key > this->key)
-             {
-               current = current->parent; 
-             }
-       
-             return current;
-           }
-       
-           //Return NULL if no option found
-           return NULL;
-         }
-       
          //--------------------------------------------------------------------------------------
          //Interator functions-------------------------------------------------------------------
          //--------------------------------------------------------------------------------------
          /************************************************************
-          * @brief: Construct a new bstmap iterator
+          * @brief: Construct a new bstmap iterator, nodes are shared
+          *         between maps so they have no single parent, the
+          *         iterator finds the path from the root the first
+          *         time it needs it instead
           *          
-          * @param p: Pointer to node to set as p_node
+          * @param m: Map this iterator walks through
+          * @param p: Pointer to node to set as p_node, NULL for end
          *************************************************************/
          template&lttypename KEY_TYPE, typename VALUE_TYPE>
-         BSTI::BSTmap_iterator(Node* p)
-           : p_node(p)
+         BSTI::BSTmap_iterator(BSTmap* m, Node* p)
+           : p_map(m), p_node(p)
          {}
        
          /************************************************************
@@ -187,7 +103,7 @@
          *************************************************************/
          template&lttypename KEY_TYPE, typename VALUE_TYPE>
          BSTI::BSTmap_iterator(const BSTmap_iterator& rhs)
-           : p_node(rhs.p_node)
+           : p_map(rhs.p_map), path(rhs.path), p_node(rhs.p_node)
          {}
        
          /************************************************************
@@ -199,7 +115,9 @@
          template&lttypename KEY_TYPE, typename VALUE_TYPE>
          tyBSTI& BSTI::operator=(const BSTmap_iterator& rhs)
          {
-           //Set p_node's value to value of rhs
+           //Copy map, path and node of rhs
+           this->p_map = rhs.p_map;
+           this->path = rhs.path;
            this->p_node = rhs.p_node;
            return *this;
          }
@@ -213,8 +131,15 @@
          template&lttypename KEY_TYPE, typename VALUE_TYPE>
          tyBSTI& BSTI::operator++()
          {
+           //Path is only found once the iterator moves, so lookups stay allocation free
+           if(path.empty())
+           {
+             p_map->seek(p_node->key, path);
+           }
+       
            //Move one node forward
-           p_node = p_node->increment();
+           BST::step(path);
+           p_node = path.empty() ? NULL : path.back();
            return *this;
          }
        
@@ -238,27 +163,60 @@
          }
        
          /************************************************************
-          * @brief: Dereference operator for iterator, gets reference
-          *         to node in iterator
+          * @brief: Dereference operator for iterator, the iterator
+          *         itself exposes Key() and Value() so writes can go
+          *         through it and never land in a shared node
           *       
-          * @return tyBST::Node&: Node in iterator
+          * @return tyBSTI&: Self
          *************************************************************/
          template&lttypename KEY_TYPE, typename VALUE_TYPE>
-         tyBST::Node& BSTI::operator*()
+         tyBSTI& BSTI::operator*()
          {
-           return *(this->p_node);
+           return *this;
          }
        
          /************************************************************
-          * @brief: Arrow operator for iterator, gets pointer to node
-          *         in iterator
+          * @brief: Arrow operator for iterator, lets it->Key() and
+          *         it->Value() work like on the node
           *          
-          * @return tyBST::Node*: Pointer to node in iterator
+          * @return tyBSTI*: Pointer to self
+         *************************************************************/
+         template&lttypename KEY_TYPE, typename VALUE_TYPE>
+         tyBSTI* BSTI::operator->()
+         {
+           return this;
+         }
+       
+         /************************************************************
+          * @brief: Gets the key of the node at this iterator, never
+          *         copies anything
+          * 
+          * @return KEY_TYPE const&: The key of this node
+         *************************************************************/
+         template&lttypename KEY_TYPE, typename VALUE_TYPE>
+         KEY_TYPE const& BSTI::Key() const
+         {
+           return p_node->key;
+         }
+       
+         /************************************************************
+          * @brief: Gets the value of the node at this iterator to 
+          *         write to, copying the nodes on its path that are
+          *         still shared with a snapshot first
+          *    
+          * @return VALUE_TYPE&: The value of this node
          *************************************************************/
          template&lttypename KEY_TYPE, typename VALUE_TYPE>
-         tyBST::Node* BSTI::operator->()
+         VALUE_TYPE& BSTI::Value()
          {
-           return this->p_node;
+           //Only the path from the root gets copied, snapshots keep the originals, 
+           //found again by key since writes since the last one may have copied it
+           p_map->unsharePath(p_node->key, path);
+           if(!path.empty())
+           {
+             p_node = path.back();
+           }
+           return p_node->value;
          }
        
          /************************************************************
@@ -291,6 +249,130 @@
            return this->p_node == rhs.p_node;
          }
        
+         //--------------------------------------------------------------------------------------
+         //Const interator functions-------------------------------------------------------------
+         //--------------------------------------------------------------------------------------
+         /************************************************************
+          * @brief: Construct a new const bstmap iterator
+          *          
+          * @param m: Map this iterator walks through
+          * @param p: Pointer to node to set as p_node, NULL for end
+         *************************************************************/
+         template&lttypename KEY_TYPE, typename VALUE_TYPE>
+         BSTIC::BSTmap_iterator_const(const BSTmap* m, Node* p)
+           : p_map(m), p_node(p)
+         {}
+       
+         /************************************************************
+          * @brief: PlusPlus prefix operator for const iterators,
+          *         increments the iterator by one
+          *         
+          * @return tyBSTIC&: Self after operation
+         *************************************************************/
+         template&lttypename KEY_TYPE, typename VALUE_TYPE>
+         tyBSTIC& BSTIC::operator++()
+         {
+           //Path is only found once the iterator moves, so lookups stay allocation free
+           if(path.empty())
+           {
+             p_map->seek(p_node->key, path);
+           }
+       
+           //Move one node forward
+           BST::step(path);
+           p_node = path.empty() ? NULL : path.back();
+           return *this;
+         }
+       
+         /************************************************************
+          * @brief: PlusPlus postfix operator for const iterators,
+          *         increments the iterator by one
+          *          
+          * @return tyBSTIC: Self before operation
+         *************************************************************/
+         template&lttypename KEY_TYPE, typename VALUE_TYPE>
+         tyBSTIC BSTIC::operator++(int)
+         {
+           //Make a copy of the original
+           BSTmap_iterator_const orignal(*this);
+       
+           //Increment iterator
+           ++(*this);
+       
+           //Return original value
+           return orignal;
+         }
+       
+         /************************************************************
+          * @brief: Dereference operator for const iterators
+          *       
+          * @return tyBSTIC&: Self
+         *************************************************************/
+         template&lttypename KEY_TYPE, typename VALUE_TYPE>
+         tyBSTIC& BSTIC::operator*()
+         {
+           return *this;
+         }
+       
+         /************************************************************
+          * @brief: Arrow operator for const iterators
+          *          
+          * @return tyBSTIC*: Pointer to self
+         *************************************************************/
+         template&lttypename KEY_TYPE, typename VALUE_TYPE>
+         tyBSTIC* BSTIC::operator->()
+         {
+           return this;
+         }
+       
+         /************************************************************
+          * @brief: Gets the key of the node at this const iterator
+          * 
+          * @return KEY_TYPE const&: The key of this node
+         *************************************************************/
+         template&lttypename KEY_TYPE, typename VALUE_TYPE>
+         KEY_TYPE const& BSTIC::Key() const
+         {
+           return p_node->key;
+         }
+       
+         /************************************************************
+          * @brief: Gets the value of the node at this const iterator
+          *    
+          * @return VALUE_TYPE const&: The value of this node
+         *************************************************************/
+         template&lttypename KEY_TYPE, typename VALUE_TYPE>
+         VALUE_TYPE const& BSTIC::Value() const
+         {
+           return p_node->value;
+         }
+       
+         /************************************************************
+          * @brief: Inverse Equality operator for const iterators
+          *         
+          * @param rhs: Right hand side of operation
+          * @return true: Nodes dont match
+          * @return false:  Nodes match
+         *************************************************************/
+         template&lttypename KEY_TYPE, typename VALUE_TYPE>
+         bool BSTIC::operator!=(const BSTmap_iterator_const& rhs)
+         {
+           return !(this->p_node == rhs.p_node);
+         }
+       
+         /************************************************************
+          * @brief: Equality operator for const iterators
+          *      
+          * @param rhs: Right hand side of operaton
+          * @return true: Nodes match
+          * @return false: Nodes dont match
+         *************************************************************/
+         template&lttypename KEY_TYPE, typename VALUE_TYPE>
+         bool BSTIC::operator==(const BSTmap_iterator_const& rhs)
+         {
+           return this->p_node == rhs.p_node;
+         }
+       
          //---------------------------------------------------------------------------------------
          //BSTmap Constructors/Destructors--------------------------------------------------------
          //---------------------------------------------------------------------------------------
@@ -302,25 +384,28 @@
          {}
        
          /************************************************************
-          * @brief: Construct a new BSTmap from another BSTmap
+          * @brief: Construct a new BSTmap from another BSTmap, the
+          *         nodes are shared with rhs (O(1)) and only get
+          *         copied once either map is written to
           *       
           * @param rhs: BSTmap to copy from
          *************************************************************/
          template&lttypename KEY_TYPE, typename VALUE_TYPE>
          BST::BSTmap(const BSTmap& rhs)
          {
-           //Add all nodes from rhs
-           addAll(rhs.pRoot);
+           //Share all nodes from rhs
+           share(rhs);
          }
        
          /************************************************************
-          * @brief: Destroy BSTmap, frees all nodes      
+          * @brief: Destroy BSTmap, frees all nodes if no other map
+          *         is still sharing them
          *************************************************************/
          template&lttypename KEY_TYPE, typename VALUE_TYPE>
          BST::~BSTmap()
          {
-           //Free all nodes
-           freeAll(&pRoot);
+           //Free or let go of all nodes
+           release();
          }
        
          //---------------------------------------------------------------------------------------
@@ -335,9 +420,12 @@
          template&lttypename KEY_TYPE, typename VALUE_TYPE>
          tyBST::BSTmap& BST::operator=(const BSTmap& rhs)
          {
-           //Empty and replace with rhs
-           freeAll(&pRoot);
-           addAll(rhs.pRoot);
+           //Empty and share rhs's nodes
+           if(this != &rhs)
+           {
+             release();
+             share(rhs);
+           }
        
            //Return self
            return *this;
@@ -345,7 +433,9 @@
        
          /************************************************************
           * @brief: Operator brackets for BSTmap, gets reference to
-          *         node with passed key (created if not found)
+          *         node with passed key (created if not found), only
+          *         nodes on the path to it that are shared with a 
+          *         snapshot get copied
           * 
           * @param key: Key to use to find node
           * @return VALUE_TYPE&: Reference to node with passed key
@@ -353,41 +443,38 @@
          template&lttypename KEY_TYPE, typename VALUE_TYPE>
          VALUE_TYPE& BST::operator[](KEY_TYPE const& key)
          {
-           //Search for the key in the binary search tree
-           Node* last;
-           Node* node = findNode(key, &last);
-       
-           //If the key was not found, insert it into the tree
-           if (node == NULL) 
+           //Search for the key, taking ownership of each node on the way down
+           Node** link = &pRoot;
+           while (*link != NULL) 
            {
-             //Insert node into the tree (with defualt value and no branches)
-             node = new Node(key, VALUE_TYPE(), last, -1, -1, NULL, NULL);
-             addNode(last, node);
+             Node* node = unshare(link);
+             if (node->key == key)
+             {
+               return node->value;
+             }
+       
+             //Go left or right
+             link = (key > node->key) ? &node->right : &node->left;
            }
        
-           //Return a reference to the value associated with the key
-           return node->value;
+           //Key was not found, insert it where the search ended (with defualt value and no branches)
+           *link = createNode(key, VALUE_TYPE());
+           ++size_;
+           return (*link)->value;
          }     
          
          /************************************************************
           * @brief: Gets the start of this BSTmap as an iterator, 
-          *         returns end if no starting node
+          *         returns end if no starting node, does not copy
+          *         shared nodes until a value is written
           *    
           * @return tyBST::BSTmap_iterator: Begining of this BSTmap
          *************************************************************/
          template&lttypename KEY_TYPE, typename VALUE_TYPE>
          tyBST::BSTmap_iterator BST::begin() 
          {
-           //If the root exists
-           if (pRoot) 
-           {
-             //Return it as an iterator
-             return BST::BSTmap_iterator(pRoot->first());
-           }
-           else
-           {
-             return end_it;
-           }
+           //Smallest key, or end if empty
+           return BSTmap_iterator(this, firstNode());
          }
        
          /************************************************************
@@ -403,7 +490,8 @@
          }
        
          /************************************************************
-          * @brief: Finds node with passed key in BSTmap
+          * @brief: Finds node with passed key in BSTmap, does not 
+          *         copy shared nodes until a value is written
           *     
           * @param key: Key of node to find
           * @return tyBST::BSTmap_iterator: Iterator to wanted node 
@@ -411,19 +499,116 @@
          template&lttypename KEY_TYPE, typename VALUE_TYPE>
          tyBST::BSTmap_iterator BST::find(KEY_TYPE const& key)
          {
-           //Find node with passed key
-           Node* node = findNode(key);
+           //Node with the key, or end if not found
+           return BSTmap_iterator(this, findNode(key));
+         } 
        
-           //If node was found
-           if(node != NULL)
-           {
-             //Return interator to it
-             return BSTmap_iterator(node);
-           }
+         /************************************************************
+          * @brief: Gets the start of this BSTmap as a const 
+          *         iterator
+          *    
+          * @return tyBST::BSTmap_iterator_const: Begining of this
+          *                                       BSTmap
+         *************************************************************/
+         template&lttypename KEY_TYPE, typename VALUE_TYPE>
+         tyBST::BSTmap_iterator_const BST::begin() const
+         {
+           //Smallest key, or end if empty
+           return BSTmap_iterator_const(this, firstNode());
+         }
        
-           //Return end of list if failed
-           return this->end();
-         } 
+         /************************************************************
+          * @brief: Returns the const end of this BSTmap (which is 
+          *         always NULL)
+          *        
+          * @return tyBST::BSTmap_iterator_const: End of this BSTmap
+         *************************************************************/
+         template&lttypename KEY_TYPE, typename VALUE_TYPE>
+         tyBST::BSTmap_iterator_const BST::end() const
+         {
+           return BST::const_end_it;
+         }
+       
+         /************************************************************
+          * @brief: Finds node with passed key in BSTmap without 
+          *         allowing writes
+          *     
+          * @param key: Key of node to find
+          * @return tyBST::BSTmap_iterator_const: Iterator to wanted 
+          *                                       node
+         *************************************************************/
+         template&lttypename KEY_TYPE, typename VALUE_TYPE>
+         tyBST::BSTmap_iterator_const BST::find(KEY_TYPE const& key) const
+         {
+           //Node with the key, or end if not found
+           return BSTmap_iterator_const(this, findNode(key));
+         }
+       
+         /************************************************************
+          * @brief: Takes a snapshot of this BSTmap in O(1), the
+          *         snapshot stays readable and unchanged while this
+          *         map keeps being written to
+          *      
+          * @return BST: Snapshot sharing this BSTmap's nodes
+         *************************************************************/
+         template&lttypename KEY_TYPE, typename VALUE_TYPE>
+         BST BST::snapshot() const
+         {
+           //Copying only shares the nodes
+           return BSTmap(*this);
+         }
+       
+         /************************************************************
+          * @brief: Gets the height of this BSTmap, the number of 
+          *         nodes on the longest path from the root (lookups
+          *         cost up to this many compares)
+          *      
+          * @return unsigned int: Height of this BSTmap
+         *************************************************************/
+         template&lttypename KEY_TYPE, typename VALUE_TYPE>
+         unsigned int BST::height() const
+         {
+           return heightOf(pRoot);
+         }
+       
+         /************************************************************
+          * @brief: Gets the total number of nodes allocated by all
+          *         BSTmaps of this type, for measuring allocation
+          *         traffic around a workload
+          *      
+          * @return unsigned long long: Nodes allocated so far
+         *************************************************************/
+         template&lttypename KEY_TYPE, typename VALUE_TYPE>
+         unsigned long long BST::allocations()
+         {
+           return allocationCount.load(std::memory_order_relaxed);
+         }
+       
+         /************************************************************
+          * @brief: Gets the number of nodes allocated by all BSTmaps
+          *         of this type that have not been freed yet
+          *      
+          * @return unsigned long long: Nodes currently alive
+         *************************************************************/
+         template&lttypename KEY_TYPE, typename VALUE_TYPE>
+         unsigned long long BST::liveNodes()
+         {
+           //Read frees first, so a free racing this read cant make the count go negative
+           unsigned long long freed = freeCount.load(std::memory_order_relaxed);
+           return allocationCount.load(std::memory_order_relaxed) - freed;
+         }
+       
+         /************************************************************
+          * @brief: Gets the number of bytes each node takes, not
+          *         counting the allocator's own overhead
+          *      
+          * @return unsigned int: Size of one node in bytes
+         *************************************************************/
+         template&lttypename KEY_TYPE, typename VALUE_TYPE>
+         unsigned int BST::bytesPerNode()
+         {
+           return sizeof(Node);
+         }
        
          /************************************************************
           * @brief: Gets the size of this BSTmap, which is the number
@@ -432,87 +617,161 @@
           * @return unsigned int: Number of nodes in this BSTmap
          *************************************************************/
          template&lttypename KEY_TYPE, typename VALUE_TYPE>
-         unsigned int BST::size()
+         unsigned int BST::size() const
          {
            //Return the size of the map (number of nodes)
            return size_;
          }
        
          /************************************************************
-          * @brief: Erased node at passed iterator from BSTmap
+          * @brief: Erased node at passed iterator from BSTmap, the 
+          *         node is found again by key so an iterator taken
+          *         before a snapshot never frees the snapshot's node
           *     
           * @param it: Iterator to node to erase
          *************************************************************/
          template&lttypename KEY_TYPE, typename VALUE_TYPE>
          void BST::erase(BSTmap_iterator it)
          {
-           //Get node out of interator
-           Node* node = it.p_node;
-       
-           //If node has no branches
-           if(node->right == NULL && node->left == NULL)
+           //Nothing to erase at end
+           if(it.p_node == NULL)
            {
-             //Update the parent node to NULL
-             updateParent(node, NULL);
+             return;
+           }
        
-             //Delete this node
-             freeNode(&node);
+           //Search for the key, taking ownership of each node on the way down
+           KEY_TYPE key = it.p_node->key;
+           Node** link = &pRoot;
+           while(*link != NULL && (*link)->key != key)
+           {
+             Node* node = unshare(link);
+             link = (key > node->key) ? &node->right : &node->left;
            }
-           //If node only has right branch
-           else if (node->left == NULL)
+       
+           //Key is no longer in this map
+           if(*link == NULL)
            {
-             //Update the parent node of right branch
-             updateParent(node, node->right);
+             return;
+           }
+           Node* node = unshare(link);
        
-             //Delete original node
-             freeNode(&node);
+           //If node only has right branch (or none), move it up
+           if(node->left == NULL)
+           {
+             *link = node->right;
            }
-           //If node only has left branch
-           else if (node->right == NULL)
+           //If node only has left branch, move it up
+           else if(node->right == NULL)
            {
-             //Update the parent node of left branch
-             updateParent(node, node->left);
-       
-             //Delete original node
-             freeNode(&node);
+             *link = node->left;
            }
            //If node has two branches
            else
            {
              //Get predecessor from node below self
-             Node* pred = node->left->last();
+             Node** predLink = &node->left;
+             while(unshare(predLink)->right != NULL)
+             {
+               predLink = &(*predLink)->right;
+             }
+             Node* pred = *predLink;
        
-             //Set node to pred's data
+             //Set node to pred's data and unlink pred instead
              node->key = pred->key;
              node->value = pred->value;
-       
-             //Call erase on pred
-             erase(BSTmap_iterator(pred));
+             *predLink = pred->left;
+             node = pred;
            }
+       
+           //Branches moved up with their references, so only the node itself is freed
+           freeNode(&node);
+           --size_;
          }
-
+       
          /************************************************************
-          * @brief: Finds node of passed key in this BSTmap, returns
-          *         NULL if not found, sets last as the node before
-          *         found node (even if not found), Last is not 
-          *         required and can be left NULL
-          *       
-          * @param key: Key to search for
-          * @param last: Will be set to the node beforefound node 
-          *              (even if not found), NULL by defualt
-          * @return tyBST::Node*: Pointer to Node with passed key,
-          *                       NULL if not found
+          * @brief: Freezes this BSTmap into a flat map, copying every
+          *         node in order into contiguous sorted arrays, done
+          *         in O(n) since an in order walk is already sorted
+          *     
+          * @return FLAT: Flat map holding a copy of this BSTmap
+         *************************************************************/
+         template&lttypename KEY_TYPE, typename VALUE_TYPE>
+         FLAT BST::freeze() const
+         {
+           //Make room for every node up front
+           FLAT flat;
+           flat.keys.reserve(size_);
+           flat.values.reserve(size_);
+       
+           //Walk nodes in order, so the arrays come out sorted
+           for(BSTmap_iterator_const it = begin(); it != end(); ++it)
+           {
+             flat.keys.push_back(it->Key());
+             flat.values.push_back(it->Value());
+           }
+       
+           return flat;
+         }
+       
+         /************************************************************
+          * @brief: Finds node of passed key in this BSTmap
+          *       
+          * @param key: Key to search for
+          * @return tyBST::Node*: Pointer to Node with passed key,
+          *                       NULL if not found
          *************************************************************/
          template&lttypename KEY_TYPE, typename VALUE_TYPE>
-         tyBST::Node* BST::findNode(KEY_TYPE const& key, Node** last) const
+         tyBST::Node* BST::findNode(KEY_TYPE const& key) const
          {
            //Search for the key in the binary search tree
            Node* current = pRoot;
-           Node* lastNode = NULL;
            while (current != NULL && current->key != key) 
            {
-             //Set lastNode
-             lastNode = current;
+             //Go left or right
+             current = (key > current->key) ? current->right : current->left;
+           }
+       
+           return current;
+         }
+       
+         /************************************************************
+          * @brief: Gets the node with the smallest key by branching
+          *         as far left as possible from the root
+          *       
+          * @return tyBST::Node*: First node, NULL if empty
+         *************************************************************/
+         template&lttypename KEY_TYPE, typename VALUE_TYPE>
+         tyBST::Node* BST::firstNode() const
+         {
+           Node* current = pRoot;
+           while(current != NULL && current->left != NULL)
+           {
+             current = current->left;
+           }
+       
+           return current;
+         }
+       
+         /************************************************************
+          * @brief: Fills path with the nodes from the root down to
+          *         the node of passed key, path is left empty if the
+          *         key is not found
+          *       
+          * @param key: Key to search for
+          * @param path: Path to fill, should be empty
+         *************************************************************/
+         template&lttypename KEY_TYPE, typename VALUE_TYPE>
+         void BST::seek(KEY_TYPE const& key, std::vector&ltNode*>& path) const
+         {
+           //Search for the key in the binary search tree
+           Node* current = pRoot;
+           while (current != NULL) 
+           {
+             path.push_back(current);
+             if (current->key == key)
+             {
+               return;
+             }
        
              //Go left or right
              if (key > current->key) 
@@ -525,48 +784,124 @@
              }
            }
        
-           //Set last if needed
-           if(last != NULL)
+           //Not found
+           path.clear();
+         }
+       
+         /************************************************************
+          * @brief: Pushes passed node and every node down its left
+          *         side onto path, leaving the smallest node on top
+          *       
+          * @param node: Node to start at, can be NULL
+          * @param path: Path to add to
+         *************************************************************/
+         template&lttypename KEY_TYPE, typename VALUE_TYPE>
+         void BST::pushLeft(Node* node, std::vector&ltNode*>& path)
+         {
+           //Branch as far left as possible
+           while(node != NULL)
            {
-             *last = lastNode;
+             path.push_back(node);
+             node = node->left;
            }
+         }
        
-           return current;
+         /************************************************************
+          * @brief: Moves path one node forward, as in to the node 
+          *         with the closest greater key, path is left empty 
+          *         when there is none
+          *       
+          * @param path: Path from the root to the current node
+         *************************************************************/
+         template&lttypename KEY_TYPE, typename VALUE_TYPE>
+         void BST::step(std::vector&ltNode*>& path)
+         {
+           //Go right if possible since always larger
+           Node* node = path.back();
+           if(node->right != NULL)
+           {
+             //Get first of the right side
+             pushLeft(node->right, path);
+             return;
+           }
+       
+           //Climb until coming up out of a left branch, that parent is next
+           path.pop_back();
+           while(!path.empty() && path.back()->right == node)
+           {
+             node = path.back();
+             path.pop_back();
+           }
          }
        
          /************************************************************
-          * @brief: Adds a node to this BSTmap after nodeToAddFrom in
-          *         the proper direction
+          * @brief: Makes sure the node at link is only owned by this
+          *         map before a write, if a snapshot still shares it
+          *         it is copied and link is pointed at the copy (its
+          *         branches stay shared between both)
           * 
-          * @param nodeToAddFrom: Node to add new node after
-          * @param nodeToAdd: Node to add
+          * @param link: Root or branch pointer holding the node
+          * @return tyBST::Node*: Node at link, now owned by this map
          *************************************************************/
          template&lttypename KEY_TYPE, typename VALUE_TYPE>
-         void BST::addNode(Node* nodeToAddFrom, Node* nodeToAdd)
+         tyBST::Node* BST::unshare(Node** link)
          {
-           //Increment size
-           ++size_;
+           //Only this map reaches the node
+           Node* node = *link;
+           if(node->refs == 1)
+           {
+             return node;
+           }
        
-           //If root is not set
-           if(pRoot == NULL)
+           //Copy the node, both copies now point at its branches
+           Node* copy = createNode(node->key, node->value);
+           copy->left = node->left;
+           copy->right = node->right;
+           if(copy->left != NULL)
            {
-             //Set as root and update end iterator
-             pRoot = nodeToAdd;
+             ++copy->left->refs;
            }
-           else
+           if(copy->right != NULL)
            {
-             //If larger than node adding from 
-             if (nodeToAdd->key > nodeToAddFrom->key) 
-             {
-               //Add to the right and update end iterator
-               nodeToAddFrom->right = nodeToAdd;
-             } 
-             else 
+             ++copy->right->refs;
+           }
+       
+           //Leave the original to the snapshots
+           --node->refs;
+           *link = copy;
+           return copy;
+         }
+       
+         /************************************************************
+          * @brief: Takes ownership of every node from the root down
+          *         to the node of passed key, copying the ones still
+          *         shared, and fills path with them (left empty if the
+          *         key is not found)
+          * 
+          * @param key: Key of the node to own the path to
+          * @param path: Path to fill, anything in it is replaced
+         *************************************************************/
+         template&lttypename KEY_TYPE, typename VALUE_TYPE>
+         void BST::unsharePath(KEY_TYPE const& key, std::vector&ltNode*>& path)
+         {
+           //Walk by key, an old path can hold nodes a later write replaced
+           path.clear();
+           Node** link = &pRoot;
+           while(*link != NULL)
+           {
+             Node* node = unshare(link);
+             path.push_back(node);
+             if(node->key == key)
              {
-               //Add to the left
-               nodeToAddFrom->left = nodeToAdd;
+               return;
              }
+       
+             //Go left or right
+             link = (key > node->key) ? &node->right : &node->left;
            }
+       
+           //Not found
+           path.clear();
          }
        
          /************************************************************
@@ -580,93 +915,544 @@
            //Delete node and set to null
            delete *node;
            *node = NULL;
-           --size_;
+           freeCount.fetch_add(1, std::memory_order_relaxed);
          }
        
          /************************************************************
-          * @brief: Updates parent data of oldChild to have instead
-          *         have newChild, also handles if parent is root,  
-          *         and updating parent pointers of children
-          *     
-          * @param oldChild: Child of parent to update
-          * @param newChild: Child to replace oldChild
+          * @brief: Allocates a new node with no branches, every node
+          *         is made here so allocations can be counted
+          * 
+          * @param key: Key of the new node
+          * @param value: Value of the new node
+          * @return tyBST::Node*: Newly allocated node
          *************************************************************/
          template&lttypename KEY_TYPE, typename VALUE_TYPE>
-         void BST::updateParent(Node* oldChild, Node* newChild)
+         tyBST::Node* BST::createNode(KEY_TYPE const& key, VALUE_TYPE const& value)
          {
-           //If parent exists
-           if(oldChild->parent != NULL)
+           allocationCount.fetch_add(1, std::memory_order_relaxed);
+           return new Node(key, value, NULL, NULL);
+         }
+       
+         /************************************************************
+          * @brief: Gets the height of passed node, counting the node
+          *         itself (so NULL is 0 and a leaf is 1), walks with
+          *         its own stack since sorted inserts leave a branch
+          *         as long as the map
+          * 
+          * @param node: Node to get the height of
+          * @return unsigned int: Height of the node
+         *************************************************************/
+         template&lttypename KEY_TYPE, typename VALUE_TYPE>
+         unsigned int BST::heightOf(Node* node) const
+         {
+           //Nodes left to visit with their depth
+           std::vector&ltstd::pair&ltNode*, unsigned int>> pending;
+           if(node != NULL)
+           {
+             pending.push_back(std::make_pair(node, 1u));
+           }
+       
+           //Deepest node found is the height
+           unsigned int height = 0;
+           while(!pending.empty())
            {
-             //Set parent pointing to self to new node
-             if (oldChild->parent->left == oldChild)
+             Node* current = pending.back().first;
+             unsigned int depth = pending.back().second;
+             pending.pop_back();
+       
+             height = (depth > height) ? depth : height;
+             if(current->left != NULL)
              {
-               oldChild->parent->left = newChild;
+               pending.push_back(std::make_pair(current->left, depth + 1));
              }
-             else
+             if(current->right != NULL)
              {
-               oldChild->parent->right = newChild;
+               pending.push_back(std::make_pair(current->right, depth + 1));
              }
            }
-           //No parent, so oldChild is root
-           else
+       
+           return height;
+         }
+       
+         /************************************************************
+          * @brief: Shares all nodes of rhs with this BSTmap, only the
+          *         root gets another owner since everything below is
+          *         reached through it, this map must be empty
+          *     
+          * @param rhs: BSTmap to share nodes with
+         *************************************************************/
+         template&lttypename KEY_TYPE, typename VALUE_TYPE>
+         void BST::share(const BSTmap& rhs)
+         {
+           //Point at the same nodes and add self as an owner
+           pRoot = rhs.pRoot;
+           size_ = rhs.size_;
+           if(pRoot != NULL)
            {
-             //Set root to newChild
-             pRoot = newChild;
+             ++pRoot->refs;
            }
+         }
        
-           //If new child exists
-           if(newChild != NULL)
+         /************************************************************
+          * @brief: Lets go of this BSTmap's nodes, only freeing the
+          *         ones no other map still reaches, walks with its
+          *         own stack so deep trees cant overflow
+         *************************************************************/
+         template&lttypename KEY_TYPE, typename VALUE_TYPE>
+         void BST::release()
+         {
+           //Nodes left to let go of
+           std::vector&ltNode*> dropped;
+           if(pRoot != NULL)
            {
-             //Update its parent
-             newChild->parent = oldChild->parent;
+             dropped.push_back(pRoot);
+           }
+       
+           while(!dropped.empty())
+           {
+             Node* node = dropped.back();
+             dropped.pop_back();
+       
+             //Last owner frees the node and lets go of its branches
+             if(--node->refs == 0)
+             {
+               if(node->left != NULL)
+               {
+                 dropped.push_back(node->left);
+               }
+               if(node->right != NULL)
+               {
+                 dropped.push_back(node->right);
+               }
+               freeNode(&node);
+             }
            }
        
-           //Delete old child's parent
-           oldChild->parent = NULL;
+           pRoot = NULL;
+           size_ = 0;
+         }
+       
+         //--------------------------------------------------------------------------------------
+         //Flat map interator functions----------------------------------------------------------
+         //--------------------------------------------------------------------------------------
+         /************************************************************
+          * @brief: Construct a new flat map iterator
+          *          
+          * @param m: Flat map this iterator walks through
+          * @param i: Index of the entry this iterator points to
+         *************************************************************/
+         template&lttypename KEY_TYPE, typename VALUE_TYPE>
+         FLATI::BSTflatmap_iterator(BSTflatmap* m, unsigned int i)
+           : p_map(m), index(i)
+         {}
+       
+         /************************************************************
+          * @brief: Gets the key of the entry at this iterator
+          * 
+          * @return KEY_TYPE const&: The key of this entry
+         *************************************************************/
+         template&lttypename KEY_TYPE, typename VALUE_TYPE>
+         KEY_TYPE const& FLATI::Key() const
+         {
+           return p_map->keys[index];
+         }
+       
+         /************************************************************
+          * @brief: Gets the value of the entry at this iterator
+          *    
+          * @return VALUE_TYPE&: The value of this entry
+         *************************************************************/
+         template&lttypename KEY_TYPE, typename VALUE_TYPE>
+         VALUE_TYPE& FLATI::Value()
+         {
+           return p_map->values[index];
+         }
+       
+         /************************************************************
+          * @brief: PlusPlus prefix operator for flat iterators,
+          *         increments the iterator by one
+          *         
+          * @return tyFLATI&: Self after operation
+         *************************************************************/
+         template&lttypename KEY_TYPE, typename VALUE_TYPE>
+         tyFLATI& FLATI::operator++()
+         {
+           //Entries are stored in order, so just step forward
+           ++index;
+           return *this;
+         }
+       
+         /************************************************************
+          * @brief: PlusPlus postfix operator for flat iterators,
+          *         increments the iterator by one
+          *          
+          * @return tyFLATI: Self before operation
+         *************************************************************/
+         template&lttypename KEY_TYPE, typename VALUE_TYPE>
+         tyFLATI FLATI::operator++(int)
+         {
+           //Make a copy of the original
+           BSTflatmap_iterator orignal(*this);
+       
+           //Increment iterator
+           ++(*this);
+       
+           //Return original value
+           return orignal;
+         }
+       
+         /************************************************************
+          * @brief: Dereference operator for flat iterators, the
+          *         iterator itself exposes Key() and Value() so it
+          *         reads the same as a BSTmap node
+          *       
+          * @return tyFLATI&: Self
+         *************************************************************/
+         template&lttypename KEY_TYPE, typename VALUE_TYPE>
+         tyFLATI& FLATI::operator*()
+         {
+           return *this;
+         }
+       
+         /************************************************************
+          * @brief: Arrow operator for flat iterators, lets it->Key()
+          *         and it->Value() work like on BSTmap iterators
+          *          
+          * @return tyFLATI*: Pointer to self
+         *************************************************************/
+         template&lttypename KEY_TYPE, typename VALUE_TYPE>
+         tyFLATI* FLATI::operator->()
+         {
+           return this;
+         }
+       
+         /************************************************************
+          * @brief: Inverse Equality operator for flat iterators, 
+          *         checks if entries dont match
+          *         
+          * @param rhs: Right hand side of operation
+          * @return true: Entries dont match
+          * @return false: Entries match
+         *************************************************************/
+         template&lttypename KEY_TYPE, typename VALUE_TYPE>
+         bool FLATI::operator!=(const BSTflatmap_iterator& rhs)
+         {
+           return !(*this == rhs);
+         }
+       
+         /************************************************************
+          * @brief: Equality operator for flat iterators, checks if
+          *         entries match
+          *      
+          * @param rhs: Right hand side of operaton
+          * @return true: Entries match
+          * @return false: Entries dont match
+         *************************************************************/
+         template&lttypename KEY_TYPE, typename VALUE_TYPE>
+         bool FLATI::operator==(const BSTflatmap_iterator& rhs)
+         {
+           return this->p_map == rhs.p_map && this->index == rhs.index;
          }
        
+         //--------------------------------------------------------------------------------------
+         //Flat map const interator functions----------------------------------------------------
+         //--------------------------------------------------------------------------------------
          /************************************************************
-          * @brief: Frees all nodes in this BSTmap after passed node
+          * @brief: Construct a new const flat map iterator
           *          
-          * @param node: Starting point of freeALL
+          * @param m: Flat map this iterator walks through
+          * @param i: Index of the entry this iterator points to
+         *************************************************************/
+         template&lttypename KEY_TYPE, typename VALUE_TYPE>
+         FLATIC::BSTflatmap_iterator_const(const BSTflatmap* m, unsigned int i)
+           : p_map(m), index(i)
+         {}
+       
+         /************************************************************
+          * @brief: Gets the key of the entry at this const iterator
+          * 
+          * @return KEY_TYPE const&: The key of this entry
+         *************************************************************/
+         template&lttypename KEY_TYPE, typename VALUE_TYPE>
+         KEY_TYPE const& FLATIC::Key() const
+         {
+           return p_map->keys[index];
+         }
+       
+         /************************************************************
+          * @brief: Gets the value of the entry at this const iterator
+          *    
+          * @return VALUE_TYPE const&: The value of this entry
+         *************************************************************/
+         template&lttypename KEY_TYPE, typename VALUE_TYPE>
+         VALUE_TYPE const& FLATIC::Value() const
+         {
+           return p_map->values[index];
+         }
+       
+         /************************************************************
+          * @brief: PlusPlus prefix operator for const flat 
+          *         iterators, increments the iterator by one
+          *         
+          * @return tyFLATIC&: Self after operation
+         *************************************************************/
+         template&lttypename KEY_TYPE, typename VALUE_TYPE>
+         tyFLATIC& FLATIC::operator++()
+         {
+           ++index;
+           return *this;
+         }
+       
+         /************************************************************
+          * @brief: PlusPlus postfix operator for const flat 
+          *         iterators, increments the iterator by one
+          *          
+          * @return tyFLATIC: Self before operation
+         *************************************************************/
+         template&lttypename KEY_TYPE, typename VALUE_TYPE>
+         tyFLATIC FLATIC::operator++(int)
+         {
+           //Make a copy of the original
+           BSTflatmap_iterator_const orignal(*this);
+       
+           //Increment iterator
+           ++(*this);
+       
+           //Return original value
+           return orignal;
+         }
+       
+         /************************************************************
+          * @brief: Dereference operator for const flat iterators
+          *       
+          * @return tyFLATIC&: Self
+         *************************************************************/
+         template&lttypename KEY_TYPE, typename VALUE_TYPE>
+         tyFLATIC& FLATIC::operator*()
+         {
+           return *this;
+         }
+       
+         /************************************************************
+          * @brief: Arrow operator for const flat iterators
+          *          
+          * @return tyFLATIC*: Pointer to self
+         *************************************************************/
+         template&lttypename KEY_TYPE, typename VALUE_TYPE>
+         tyFLATIC* FLATIC::operator->()
+         {
+           return this;
+         }
+       
+         /************************************************************
+          * @brief: Inverse Equality operator for const flat 
+          *         iterators
+          *         
+          * @param rhs: Right hand side of operation
+          * @return true: Entries dont match
+          * @return false: Entries match
+         *************************************************************/
+         template&lttypename KEY_TYPE, typename VALUE_TYPE>
+         bool FLATIC::operator!=(const BSTflatmap_iterator_const& rhs)
+         {
+           return !(*this == rhs);
+         }
+       
+         /************************************************************
+          * @brief: Equality operator for const flat iterators
+          *      
+          * @param rhs: Right hand side of operaton
+          * @return true: Entries match
+          * @return false: Entries dont match
+         *************************************************************/
+         template&lttypename KEY_TYPE, typename VALUE_TYPE>
+         bool FLATIC::operator==(const BSTflatmap_iterator_const& rhs)
+         {
+           return this->p_map == rhs.p_map && this->index == rhs.index;
+         }
+       
+         //---------------------------------------------------------------------------------------
+         //Flat map members and operators---------------------------------------------------------
+         //---------------------------------------------------------------------------------------
+         /************************************************************
+          * @brief: Construct a new empty flat map, use 
+          *         BSTmap::freeze() to build one from a tree
+         *************************************************************/
+         template&lttypename KEY_TYPE, typename VALUE_TYPE>
+         FLAT::BSTflatmap()
+         {}
+       
+         /************************************************************
+          * @brief: Operator brackets for flat maps, gets reference
+          *         to value with passed key (created if not found),
+          *         inserting is O(n) so this map is meant for data
+          *         that is built once and read many times
+          * 
+          * @param key: Key to use to find value
+          * @return VALUE_TYPE&: Reference to value with passed key
          *************************************************************/
          template&lttypename KEY_TYPE, typename VALUE_TYPE>
-         void BST::freeAll(Node** node)
+         VALUE_TYPE& FLAT::operator[](KEY_TYPE const& key)
          {
-           //If this node exists
-           if(*node != NULL)
+           //Find where the key is or would be
+           unsigned int index = lowerBound(key);
+       
+           //If the key was not found, insert it in sorted position
+           if(index == keys.size() || keys[index] != key)
            {
-             //Free children
-             freeAll(&((*node)->left));
-             freeAll(&((*node)->right));
+             keys.insert(keys.begin() + index, key);
+             values.insert(values.begin() + index, VALUE_TYPE());
+           }
+       
+           return values[index];
+         }
+       
+         /************************************************************
+          * @brief: Gets the start of this flat map as an iterator
+          *    
+          * @return tyFLAT::BSTflatmap_iterator: Begining of this map
+         *************************************************************/
+         template&lttypename KEY_TYPE, typename VALUE_TYPE>
+         tyFLAT::BSTflatmap_iterator FLAT::begin()
+         {
+           return BSTflatmap_iterator(this, 0);
+         }
+       
+         /************************************************************
+          * @brief: Gets the end of this flat map as an iterator (one
+          *         past the last entry)
+          *        
+          * @return tyFLAT::BSTflatmap_iterator: End of this map
+         *************************************************************/
+         template&lttypename KEY_TYPE, typename VALUE_TYPE>
+         tyFLAT::BSTflatmap_iterator FLAT::end()
+         {
+           return BSTflatmap_iterator(this, static_cast&ltunsigned int>(keys.size()));
+         }
        
-             //Free self
-             freeNode(node);
+         /************************************************************
+          * @brief: Finds entry with passed key in this flat map
+          *     
+          * @param key: Key of entry to find
+          * @return tyFLAT::BSTflatmap_iterator: Iterator to wanted
+          *                                      entry, end if missing
+         *************************************************************/
+         template&lttypename KEY_TYPE, typename VALUE_TYPE>
+         tyFLAT::BSTflatmap_iterator FLAT::find(KEY_TYPE const& key)
+         {
+           //Find where the key is or would be
+           unsigned int index = lowerBound(key);
+       
+           //If key was found return interator to it
+           if(index != keys.size() && keys[index] == key)
+           {
+             return BSTflatmap_iterator(this, index);
            }
+       
+           //Return end of map if failed
+           return this->end();
          }
        
          /************************************************************
-          * @brief: Copies and adds all nodes starting at passed node, 
-          *         lastNode is used for recursion
+          * @brief: Gets the start of this const flat map as a const
+          *         iterator
+          *    
+          * @return tyFLAT::BSTflatmap_iterator_const: Begining of 
+          *                                            this map
+         *************************************************************/
+         template&lttypename KEY_TYPE, typename VALUE_TYPE>
+         tyFLAT::BSTflatmap_iterator_const FLAT::begin() const
+         {
+           return BSTflatmap_iterator_const(this, 0);
+         }
+       
+         /************************************************************
+          * @brief: Gets the end of this const flat map as a const
+          *         iterator (one past the last entry)
+          *        
+          * @return tyFLAT::BSTflatmap_iterator_const: End of this map
+         *************************************************************/
+         template&lttypename KEY_TYPE, typename VALUE_TYPE>
+         tyFLAT::BSTflatmap_iterator_const FLAT::end() const
+         {
+           return BSTflatmap_iterator_const(this, static_cast&ltunsigned int>(keys.size()));
+         }
+       
+         /************************************************************
+          * @brief: Finds entry with passed key in this const flat map
           *     
-          * @param node: Starting point for copying and adding
-          * @param lastNode: Parent of currently adding node, leave 
-          *                  as defualt (NULL) when calling this
-          *                  function
+          * @param key: Key of entry to find
+          * @return tyFLAT::BSTflatmap_iterator_const: Iterator to
+          *                                            wanted entry, 
+          *                                            end if missing
          *************************************************************/
          template&lttypename KEY_TYPE, typename VALUE_TYPE>
-         void BST::addAll(Node* node, Node* lastNode)
+         tyFLAT::BSTflatmap_iterator_const FLAT::find(KEY_TYPE const& key) const
          {
-           //If this node exists
-           if(node != NULL)
+           unsigned int index = lowerBound(key);
+           if(index != keys.size() && keys[index] == key)
            {
-             //Add self
-             Node* newNode = new Node( node->key, node->value, lastNode, -1, -1, NULL, NULL);
-             addNode(lastNode, newNode);
+             return BSTflatmap_iterator_const(this, index);
+           }
+           return this->end();
+         }
        
-             //Add children
-             addAll(node->left, newNode);
-             addAll(node->right, newNode);
+         /************************************************************
+          * @brief: Gets the size of this flat map, which is the
+          *         number of entries in the map
+          *      
+          * @return unsigned int: Number of entries in this map
+         *************************************************************/
+         template&lttypename KEY_TYPE, typename VALUE_TYPE>
+         unsigned int FLAT::size() const
+         {
+           return static_cast&ltunsigned int>(keys.size());
+         }
+       
+         /************************************************************
+          * @brief: Erases entry at passed iterator from flat map
+          *     
+          * @param it: Iterator to entry to erase
+         *************************************************************/
+         template&lttypename KEY_TYPE, typename VALUE_TYPE>
+         void FLAT::erase(BSTflatmap_iterator it)
+         {
+           //Shift everything after the entry down one
+           keys.erase(keys.begin() + it.index);
+           values.erase(values.begin() + it.index);
+         }
+       
+         /************************************************************
+          * @brief: Finds the index of the first key not less than
+          *         passed key, the loop has no data dependent
+          *         branches (the compare picks the next base) so it
+          *         compiles down to conditional moves for simple keys
+          *         and never mispredicts
+          *       
+          * @param key: Key to search for
+          * @return unsigned int: Index of key, or where it would be
+          *                       inserted if not found
+         *************************************************************/
+         template&lttypename KEY_TYPE, typename VALUE_TYPE>
+         unsigned int FLAT::lowerBound(KEY_TYPE const& key) const
+         {
+           //Empty map has nothing to search
+           unsigned int length = static_cast&ltunsigned int>(keys.size());
+           if(length == 0)
+           {
+             return 0;
            }
+       
+           //Halve the range each step, moving base up when the middle is smaller
+           const KEY_TYPE* base = keys.data();
+           while(length > 1)
+           {
+             unsigned int half = length / 2;
+             base = (base[half] &lt key) ? base + half : base;
+             length -= half;
+           }
+       
+           //Base is now the last key that could match, step past it if smaller
+           return static_cast&ltunsigned int>(base - keys.data()) + (*base &lt key);
          }
        }
\ No newline at end of file
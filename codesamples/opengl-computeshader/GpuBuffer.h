@@ -0,0 +1,86 @@
+       /************************************************************
+        * @file   GpuBuffer.h
+        * @author Evan Gray 
+        * 
+        * @brief: Typed views of compute shader storage buffers
+       *************************************************************/
+       #pragma once
+       
+       //Local header files
+       #include "ComputeShader.h"
+       
+       //Global header files
+       #include &ltcstring>
+       #include &ltcstddef>
+       #include &ltstring>
+       #include &lttype_traits>
+       #include &ltspan> //Needs C++20
+       #include &ltglm/glm.hpp>
+       
+       namespace Engine
+       {
+         //Typed view of a storage buffer, checks at compile time that T can be copied straight into a
+         //std430 array, CheckStride checks the rest against the linked shader
+         template&ltclass T>
+         class GpuBuffer
+         {
+           static_assert(std::is_trivially_copyable&ltT>::value, "GpuBuffer elements are copied to the gpu as raw bytes");
+           static_assert(sizeof(T) % 4 == 0, "std430 elements are made of 4 byte scalars, pad the struct");
+           static_assert(alignof(T) &lt= 16, "std430 never aligns past 16 bytes, the strides won't match");
+           static_assert(!std::is_same&ltT, glm::vec3>::value && !std::is_same&ltT, glm::ivec3>::value &&
+                         !std::is_same&ltT, glm::uvec3>::value, "vec3 arrays have a 16 byte stride in std430, use vec4");
+       
+         public:
+           //Views the buffer with passed id, the shader does the actual work
+           GpuBuffer(const ComputeShader& shader, unsigned int* bufferID)
+             : mShader(shader), mBufferID(bufferID)
+           {
+           }
+       
+           //Uploads count elements and binds the buffer at passed index
+           void Bind(int index, const T* data, size_t count, ComputeShader::flags flag) const
+           {
+             mShader.BindBufferBytes(mBufferID, index, data, sizeof(T) * count, flag);
+           }
+       
+           //Overwrites count elements starting at element first
+           void Update(size_t first, const T* data, size_t count) const
+           {
+             mShader.UpdateBufferBytes(mBufferID, sizeof(T) * first, data, sizeof(T) * count);
+           }
+       
+           //Maps the first count elements for reading, call Unmap when done (std::span needs C++20)
+           std::span&ltconst T> Map(size_t count) const
+           {
+             std::span&ltconst std::byte> bytes = mShader.MapBufferBytes(mBufferID, sizeof(T) * count);
+             return std::span&ltconst T>(reinterpret_cast&ltconst T*>(bytes.data()), bytes.size() / sizeof(T));
+           }
+       
+           //Unmaps a buffer mapped by Map
+           void Unmap() const
+           {
+             mShader.UnmapBuffer(mBufferID);
+           }
+       
+           //Copies the first count elements into data
+           void Read(T* data, size_t count) const
+           {
+             std::span&ltconst T> mapped = Map(count);
+             if (!mapped.empty())
+             {
+               std::memcpy(data, mapped.data(), mapped.size_bytes());
+               Unmap();
+             }
+           }
+       
+           //Checks T against the stride the shader was linked with, e.g. "Lights.data"
+           bool CheckStride(const std::string& variable) const
+           {
+             return mShader.CheckBufferStride(variable, sizeof(T));
+           }
+       
+         private:
+           const ComputeShader& mShader;
+           unsigned int* mBufferID;
+         };
+       }
\ No newline at end of file
@@ -10,35 +10,414 @@
        
        //Local header files
        #include "ComputeShader.h"
+       #include "GpuBuffer.h"
        #include "Renderer.h"
        
        //Global header files
        #include &ltfstream>
        #include &ltsstream>
+       #include &ltchrono>
+       #include &ltcstring>
+       #include &ltclimits>
+       #include &ltcstdint>
+       #include &ltcstdlib>
+       #include &ltalgorithm>
+       #include &ltthread>
+       #include &ltmutex>
+       #include &ltfilesystem>
+       #include &ltfunctional>
+       #include &ltdeque>
+       #include &ltstring_view>
+       #include &ltatomic>
+       #include &ltcondition_variable>
+       #include &lttype_traits>
+       #include &ltspan> //Needs C++20
        #include &ltglad/glad.h>
        
        namespace Engine
        {
+         //Folder program binaries get cached in and the tag marking a cache file
+         static const char* sProgramCacheFolder = "shadercache/";
+         static const unsigned int sProgramCacheMagic = 0x42504C4B;
+       
+         //Written at the start of every cached program binary
+         struct ProgramCacheHeader
+         {
+           unsigned int magic;  //Always sProgramCacheMagic
+           size_t key;          //Hash of the source and driver the binary was made with
+           unsigned int format; //Binary format the driver gave back
+           int length;          //Size of the binary following this header
+         };
+       
+         //A shader file with all of its includes pasted in, and every file that went into it
+         struct PreprocessedSource
+         {
+           std::string source;
+           std::vector&ltstd::pair&ltstd::string, std::filesystem::file_time_type>> files;
+         };
+       
+         //Files that have already been preprocessed, shared by all shaders since includes often are
+         static std::unordered_map&ltstd::string, PreprocessedSource> sPreprocessedSources;
+         static std::mutex sPreprocessMutex;
+       
+         //Last GL state set through ComputeShader, so binds that change nothing can be skipped, off
+         //unless turned on since code outside of ComputeShader binding things makes it go stale
+         struct GLStateCache
+         {
+           static constexpr GLuint Unknown = UINT_MAX;
+       
+           //Buffer bound to an indexed binding point
+           struct Range
+           {
+             GLuint buffer;
+             GLintptr offset;
+             GLsizeiptr size;
+           };
+       
+           //Texture bound to an image unit
+           struct Image
+           {
+             GLuint texture;
+             GLboolean layered;
+           };
+       
+           GLuint program = Unknown;
+           std::unordered_map&ltGLenum, GLuint> buffers;
+           std::unordered_map&ltuint64_t, Range> ranges;
+           std::unordered_map&ltGLuint, Image> images;
+           bool enabled = false;
+           bool deferRasterRebind = false;
+           bool rasterPending = false;
+           int issued = 0;
+           int skipped = 0;
+         };
+         static GLStateCache sStateCache;
+       
+         //Binds a program unless it already is
+         static void CachedUseProgram(GLuint program)
+         {
+           if (sStateCache.enabled && sStateCache.program == program)
+           {
+             ++sStateCache.skipped;
+             return;
+           }
+       
+           glUseProgram(program);
+           sStateCache.program = program;
+           ++sStateCache.issued;
+         }
+       
+         //Binds a buffer to a target unless it already is
+         static void CachedBindBuffer(GLenum target, GLuint buffer)
+         {
+           auto found = sStateCache.buffers.find(target);
+           if (sStateCache.enabled && found != sStateCache.buffers.end() && found->second == buffer)
+           {
+             ++sStateCache.skipped;
+             return;
+           }
+       
+           glBindBuffer(target, buffer);
+           sStateCache.buffers[target] = buffer;
+           ++sStateCache.issued;
+         }
+       
+         //Binds part of a buffer to an indexed binding point unless it already is (size 0 binds all of it)
+         static void CachedBindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size)
+         {
+           uint64_t key = (static_cast&ltuint64_t>(target) &lt&lt 32) | index;
+           auto found = sStateCache.ranges.find(key);
+           if (sStateCache.enabled && found != sStateCache.ranges.end() && found->second.buffer == buffer && 
+               found->second.offset == offset && found->second.size == size)
+           {
+             ++sStateCache.skipped;
+             return;
+           }
+       
+           if (size == 0)
+           {
+             glBindBufferBase(target, index, buffer);
+           }
+           else
+           {
+             glBindBufferRange(target, index, buffer, offset, size);
+           }
+           sStateCache.ranges[key] = { buffer, offset, size };
+           ++sStateCache.issued;
+       
+           //Indexed binds also bind the target itself
+           sStateCache.buffers[target] = buffer;
+         }
+       
+         //Binds a whole buffer to an indexed binding point unless it already is
+         static void CachedBindBufferBase(GLenum target, GLuint index, GLuint buffer)
+         {
+           CachedBindBufferRange(target, index, buffer, 0, 0);
+         }
+       
+         //Binds a texture to an image unit unless it already is
+         static void CachedBindImageTexture(GLuint unit, GLuint texture, GLboolean layered)
+         {
+           auto found = sStateCache.images.find(unit);
+           if (sStateCache.enabled && found != sStateCache.images.end() && 
+               found->second.texture == texture && found->second.layered == layered)
+           {
+             ++sStateCache.skipped;
+             return;
+           }
+       
+           glBindImageTexture(unit, texture, 0, layered, 0, GL_READ_ONLY, GL_RGBA8);
+           sStateCache.images[unit] = { texture, layered };
+           ++sStateCache.issued;
+         }
+       
+         //GL unbinds deleted buffers everywhere, so the cache has to as well (call before deleting)
+         static void ForgetBuffer(GLuint buffer)
+         {
+           for (auto& [target, bound] : sStateCache.buffers)
+           {
+             if (bound == buffer)
+             {
+               bound = 0;
+             }
+           }
+       
+           for (auto& [key, range] : sStateCache.ranges)
+           {
+             if (range.buffer == buffer)
+             {
+               range = { 0, 0, 0 };
+             }
+           }
+         }
+       
+         //A deleted program's id can be handed out again, so stop trusting it (call before deleting)
+         static void ForgetProgram(GLuint program)
+         {
+           if (sStateCache.program == program)
+           {
+             sStateCache.program = GLStateCache::Unknown;
+           }
+         }
+       
+         //Makes a string safe to put between quotes in json
+         static std::string EscapeJson(const char* text)
+         {
+           static const char* hex = "0123456789abcdef";
+           std::string escaped;
+           for (; *text != '\0'; ++text)
+           {
+             unsigned char byte = static_cast&ltunsigned char>(*text);
+             switch (*text)
+             {
+             case '"':  escaped += "\\\""; break;
+             case '\\': escaped += "\\\\"; break;
+             case '\n': escaped += "\\n"; break;
+             case '\r': escaped += "\\r"; break;
+             case '\t': escaped += "\\t"; break;
+             default:
+               //Other control characters have no short form
+               if (byte &lt 0x20)
+               {
+                 escaped += "\\u00";
+                 escaped += hex[byte >> 4];
+                 escaped += hex[byte & 0xF];
+               }
+               else
+               {
+                 escaped += *text;
+               }
+             }
+           }
+           return escaped;
+         }
+       
+         //Ids handed out to buffers made by cpu backend shaders
+         static std::atomic&ltunsigned int> sNextCpuBuffer{ 1 };
+       
+         //Worker threads shared by every cpu backend dispatch
+         class CpuThreadPool
+         {
+         public:
+           //Starts one worker per hardware thread
+           CpuThreadPool()
+           {
+             unsigned int count = std::max(1u, std::thread::hardware_concurrency());
+             for (unsigned int i = 0; i &lt count; ++i)
+             {
+               mWorkers.emplace_back(&CpuThreadPool::Work, this);
+             }
+           }
+       
+           //Stops and joins every worker
+           ~CpuThreadPool()
+           {
+             {
+               std::lock_guard&ltstd::mutex> lock(mMutex);
+               mStopping = true;
+             }
+             mWake.notify_all();
+       
+             for (std::thread& worker : mWorkers)
+             {
+               worker.join();
+             }
+           }
+       
+           //Runs job(0) to job(jobCount - 1) across the workers, returns once all are done
+           void Run(unsigned int jobCount, const std::function&ltvoid(unsigned int)>& job)
+           {
+             std::lock_guard&ltstd::mutex> runLock(mRunMutex);
+             std::unique_lock&ltstd::mutex> lock(mMutex);
+       
+             mJob = &job;
+             mNextJob = 0;
+             mJobCount = jobCount;
+             mRemaining = jobCount;
+             ++mGeneration;
+             mWake.notify_all();
+       
+             mDone.wait(lock, [this] { return mRemaining == 0; });
+             mJob = nullptr;
+           }
+       
+           //Number of workers
+           unsigned int Size() const
+           {
+             return static_cast&ltunsigned int>(mWorkers.size());
+           }
+       
+         private:
+           //Worker loop, takes jobs until told to stop
+           void Work()
+           {
+             unsigned int seen = 0;
+             std::unique_lock&ltstd::mutex> lock(mMutex);
+             while (true)
+             {
+               mWake.wait(lock, [&] { return mStopping || mGeneration != seen; });
+               if (mStopping)
+               {
+                 return;
+               }
+               seen = mGeneration;
+       
+               //Take jobs until there are none left
+               while (mNextJob &lt mJobCount)
+               {
+                 unsigned int job = mNextJob++;
+                 lock.unlock();
+                 (*mJob)(job);
+                 lock.lock();
+       
+                 if (--mRemaining == 0)
+                 {
+                   mDone.notify_all();
+                 }
+               }
+             }
+           }
+       
+           std::vector&ltstd::thread> mWorkers;
+           std::mutex mMutex;
+           std::mutex mRunMutex;
+           std::condition_variable mWake;
+           std::condition_variable mDone;
+           const std::function&ltvoid(unsigned int)>* mJob = nullptr;
+           unsigned int mNextJob = 0;
+           unsigned int mJobCount = 0;
+           unsigned int mRemaining = 0;
+           unsigned int mGeneration = 0;
+           bool mStopping = false;
+         };
+       
          /*********************************************************************
           * @brief: Creates a compute shader program from a file
           * 
           * @param  filepath: The path to the file containing the shader
+          * @param  async: If true only submits the shader to the driver, use
+          *                IsReady/Wait (or WaitForShaders) before first use
          *********************************************************************/
-         ComputeShader::ComputeShader(const std::string& filepath)
+         ComputeShader::ComputeShader(const std::string& filepath, bool async)
            : mFilePath(filepath), mComputeShaderID(0)
        	 {
+           //Time how long it takes to get the program ready
+           mLoadStart = std::chrono::steady_clock::now();
+       
        	   //Grab shaders from file
        	   std::string source = ParseShader();
+           mProgramCacheKey = GetProgramCacheKey(source);
         
-       	   //Set up shader
-       	   mComputeShaderID = CreateShader(source);
+           //Reuse the program binary from a past run if it still matches
+           mComputeShaderID = LoadProgramBinary();
+       
+       	   //Otherwise start setting up shader from source
+           if (mComputeShaderID == 0)
+           {
+       	     mComputeShaderID = CreateShader(source, &mPendingShader);
+           }
+       
+           //Finish now unless the driver is left to compile in the background
+           if (!async)
+           {
+             Wait();
+           }
        	 }
+
+         /*********************************************************************
+          * @brief: Creates a compute shader that runs a C++ kernel on the cpu
+          *         instead of a program on the gpu, for machines without one
+          *         and for checking gpu results against, makes no GL calls
+          * 
+          * @param  name: Name of the kernel (used in logs)
+          * @param  kernel: Function run once per work group, it loops over 
+          *                 the group's local invocations itself
+          * @param  localSize: Work group size, same as the shader's local_size
+         *********************************************************************/
+         ComputeShader::ComputeShader(const std::string& name, CpuKernel kernel, glm::uvec3 localSize)
+           : mFilePath(name), mComputeShaderID(0), mCpuKernel(kernel), mCpuLocalSize(localSize)
+         {
+           mReady = true;
+         }
         
          /*********************************************************************
           * @brief: Deletes this compute shader
          *********************************************************************/
        	 ComputeShader::~ComputeShader()
        	 {
+           //Stop watching for changes, a joinable watcher would terminate the program
+           DisableHotReload();
+       
+           //Cpu backend has no GL objects (and maybe no context)
+           if (mCpuKernel)
+           {
+             return;
+           }
+       
+           //Never finished building, the shader would leak otherwise
+           if (mPendingShader != 0)
+           {
+             glDeleteShader(mPendingShader);
+           }
+       
+           //Free a reload that was never swapped in
+           if (mReloadProgram != 0)
+           {
+             glDeleteShader(mReloadShader);
+             glDeleteProgram(mReloadProgram);
+           }
+       
+           //Free timing queries, including any still waiting on results
+           for (const TimingScope& scope : mTimingsInFlight)
+           {
+             mFreeQueries.push_back(scope.startQuery);
+             mFreeQueries.push_back(scope.endQuery);
+           }
+           glDeleteQueries(static_cast&ltGLsizei>(mFreeQueries.size()), mFreeQueries.data());
+       
+           ForgetBuffer(mUniformBlockBuffer);
+           glDeleteBuffers(1, &mUniformBlockBuffer);
+           ForgetProgram(mComputeShaderID);
        	   glDeleteProgram(mComputeShaderID);
        	 }
         
@@ -54,426 +433,2304 @@
          *********************************************************************/
        	 void ComputeShader::Dispatch(glm::vec3 groupDimensions, int memoryBarrierType) const
        	 {
-       	   glDispatchCompute(groupDimensions.x, groupDimensions.y, groupDimensions.z);
+           Dispatch(glm::uvec3(groupDimensions.x, groupDimensions.y, groupDimensions.z), memoryBarrierType);
+       	 }
+       
+         /*********************************************************************
+          * @brief: Dispatches this compute shader
+          * 
+          * @param  groupCounts: Number of work groups in x, y and z
+          * @param  memoryBarrierType: opengl memory barrier type code (use
+          *                           their defines), pass 0 for no barrier
+         *********************************************************************/
+         void ComputeShader::Dispatch(glm::uvec3 groupCounts, int memoryBarrierType) const
+         {
+           //Cpu backend runs the kernel right away, so no barrier is needed
+           if (mCpuKernel)
+           {
+             RunCpuKernel(groupCounts);
+             return;
+           }
+       
+           //Send any block uniforms changed since the last dispatch in one go
+           UploadUniformBlock();
+       
+       	   glDispatchCompute(groupCounts.x, groupCounts.y, groupCounts.z);
         
            //If memory barrier is needed
        	   if (memoryBarrierType != 0)
        	   {
        	     glMemoryBarrier(memoryBarrierType);
        	   }
-       	 }
+         }
+       
+         /*********************************************************************
+          * @brief: Dispatches this compute shader with work group counts read
+          *         from a buffer on the gpu, so earlier gpu work can size it 
+          *         without a readback
+          * 
+          * @param  bufferID: Id of buffer holding the x, y, z group counts
+          * @param  offset: Byte offset of the counts in the buffer
+          * @param  memoryBarrierType: opengl memory barrier type code (use
+          *                           their defines), pass 0 for no barrier
+         *********************************************************************/
+         void ComputeShader::DispatchIndirect(unsigned int bufferID, intptr_t offset, int memoryBarrierType) const
+         {
+           //Cpu backend reads the group counts straight out of its buffer
+           if (mCpuKernel)
+           {
+             //The three counts have to be inside the buffer
+             auto buffer = mCpuBuffers.find(bufferID);
+             if (buffer == mCpuBuffers.end() || offset &lt 0 || 
+                 static_cast&ltsize_t>(offset) + 3 * sizeof(unsigned int) > buffer->second.size())
+             {
+               KL_ERROR("Indirect dispatch of {} reads outside buffer {} (offset {})", mFilePath, bufferID, offset)
+               return;
+             }
+       
+             const unsigned int* counts = reinterpret_cast&ltconst unsigned int*>(buffer->second.data() + offset);
+             RunCpuKernel(glm::uvec3(counts[0], counts[1], counts[2]));
+             return;
+           }
+       
+           //Send any block uniforms changed since the last dispatch in one go
+           UploadUniformBlock();
+       
+           CachedBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, bufferID);
+           glDispatchComputeIndirect(offset);
+       
+           //If memory barrier is needed
+       	   if (memoryBarrierType != 0)
+       	   {
+       	     glMemoryBarrier(memoryBarrierType);
+       	   }
+         }
         
          /*********************************************************************
           * @brief: Binds this shader
          *********************************************************************/
        	 void ComputeShader::Bind() const
        	 {
-       	   glUseProgram(mComputeShaderID);
-       	 }
-        
-         /********************************************************************* 
-          * @brief: Binds texture to compute shader
-          * 
-          * @param  textureID: Id of texture to bind
-          * @param  index: Index of texture in compute shader
-          * @param  layered: If this texture is layered
-         *********************************************************************/
-       	 void ComputeShader::BindTexture(unsigned int textureID, int index, bool layered) const
-       	 {
-       	   glBindImageTexture(index, textureID, 0, layered, 0, GL_READ_ONLY, GL_RGBA8);
+           //Cpu backend has nothing to bind
+           if (mCpuKernel)
+           {
+             return;
+           }
+       
+           //Async shaders have to be done building before use
+           Wait();
+       
+       	   CachedUseProgram(mComputeShaderID);
        	 }
         
          /*********************************************************************
-          * @brief: Makes a buffer and sets the id
+          * @brief: Checks if this shader is done building without waiting on
+          *         the driver, finishes setting it up the first time it is
           * 
-          * @param  bufferID: Will be filled with id of this buffer
+          * @return True if this shader can be used without stalling
          *********************************************************************/
-       	 void ComputeShader::GenBuffer(unsigned int* bufferID) const
-       	 {
-       	   //Generate buffer
-       	   glGenBuffers(1, bufferID);
-       	   glBindBuffer(GL_SHADER_STORAGE_BUFFER, *bufferID);
-       	 }
-        
+         bool ComputeShader::IsReady() const
+         {
+           //Already done
+           if (mReady)
+           {
+             return true;
+           }
+       
+           //Ask driver if it is still working on it (without the extension the only option is to wait)
+           if (GLAD_GL_KHR_parallel_shader_compile && mPendingShader != 0)
+           {
+             GLint complete = GL_FALSE;
+             glGetProgramiv(mComputeShaderID, GL_COMPLETION_STATUS_KHR, &complete);
+             if (complete == GL_FALSE)
+             {
+               return false;
+             }
+           }
+       
+           FinishShader();
+           return true;
+         }
+       
          /*********************************************************************
-          * @brief: Binds a buffer's data to the compute shader
-          * 
-          * @param  bufferID: Id of buffer to bind
-          * @param  index: Index of buffer in compute shader
-          * @param  data: Array data to bind
-          * @param  size: Size of array to bind
-          * @param  flag: Flag for buffer
+          * @brief: Waits for this shader to be done building, does nothing if
+          *         it already is
          *********************************************************************/
-       	 void ComputeShader::BindBuffer(unsigned int* bufferID, 
-                                        int index, 
-                                        float* data, 
-                                        int size, 
-                                        ComputeShader::flags flag) const
-       	 {
-       	   glBindBuffer(GL_SHADER_STORAGE_BUFFER, *bufferID);
-        
-       	   //Set buffer data
-       	   glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(float) * size, data, flag);
-        
-       	   //Send data to compute
-       	   glBindBufferBase(GL_SHADER_STORAGE_BUFFER, index, *bufferID);
-       	 }
-        
+         void ComputeShader::Wait() const
+         {
+           if (!mReady)
+           {
+             FinishShader();
+           }
+         }
+       
          /*********************************************************************
-          * @brief: Reads data from a buffer on the pu
+          * @brief: Waits for every passed shader to be done building, create
+          *         them all async first so the driver builds them together
           * 
-          * @param  bufferID: Id of buffer to read from
-          * @param  data: Will be filled with read data
-          * @param  size: Size of array to fill
+          * @param  shaders: Shaders to wait on
          *********************************************************************/
-       	 void ComputeShader::ReadBuffer(unsigned int* bufferID, float** data, int size) const
-       	 {
-       	   glBindBuffer(GL_SHADER_STORAGE_BUFFER, *bufferID);
-        
-       	   //Get data from compute
-       	   float* updatedData = static_cast&ltfloat*>(glMapBuffer(GL_SHADER_STORAGE_BUFFER, GL_READ_ONLY));
-       	   if (updatedData) 
-       	   {
-       	     for (int i = 0; i &lt size; ++i)
-       	     {
-               (*data)[i] = updatedData[i];
-       	     }
-        
-       	     glUnmapBuffer(GL_SHADER_STORAGE_BUFFER);
-       	   }
-       	 }
-        
+         void ComputeShader::WaitForShaders(const std::vector&ltComputeShader*>& shaders)
+         {
+           auto start = std::chrono::steady_clock::now();
+           for (ComputeShader* shader : shaders)
+           {
+             shader->Wait();
+           }
+       
+           std::chrono::duration&ltfloat, std::milli> time = std::chrono::steady_clock::now() - start;
+           KL_INFO("Waited {}ms for {} compute shaders to finish building", time.count(), shaders.size())
+         }
+       
          /*********************************************************************
-          * @brief: Deletes a buffer created by GenBuffer
-          * 
-          * @param  bufferID: Id of buffer to delete
+          * @brief: Starts watching this shader's file (and everything it
+          *         includes) on a background thread, changed files are
+          *         preprocessed there and picked up by CheckReload
          *********************************************************************/
-       	 void ComputeShader::DeleteBuffer(unsigned int* bufferID) const
-       	 {
-       	   //Delete buffer
-       	   glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
-       	   glDeleteBuffers(1, bufferID);
-       	 }
-        
+         void ComputeShader::EnableHotReload()
+         {
+           //Already watching
+           if (mWatching)
+           {
+             return;
+           }
+       
+           //Cpu kernels are compiled in, there is no file to watch
+           if (mCpuKernel)
+           {
+             KL_WARN("Compute shader {} runs a cpu kernel and can't be hot reloaded", mFilePath)
+             return;
+           }
+       
+           mWatching = true;
+           mWatcher = std::thread(&ComputeShader::WatchFiles, this);
+         }
+       
          /*********************************************************************
-          * @brief: Unbinds shader
+          * @brief: Stops watching this shader's files
          *********************************************************************/
-       	 void ComputeShader::Unbind() const
-       	 {
-       	   //Turn of this shader and go back to image drawing shader
-       	   glUseProgram(0);
-       	   RendererGetShader()->Bind();
-       	 }
-        
+         void ComputeShader::DisableHotReload()
+         {
+           mWatching = false;
+           if (mWatcher.joinable())
+           {
+             mWatcher.join();
+           }
+         }
+       
          /*********************************************************************
-          * @brief: Sets a uniforms by name's information
-          * 
-          * @param  name:  Name of the uniform to set
-          * @param  input: uniform information to set (overloaded to different
-          *                types)
+          * @brief: Builds and swaps in changed shader source found by the 
+          *         watcher, call once a frame before binding, never waits on 
+          *         the driver if it can compile in the background, keeps the
+          *         old program if the new one fails (uniform handles should 
+          *         be looked up again when GetReloadCount changes)
          *********************************************************************/
-       	 void ComputeShader::SetUniform(const std::string& name, float input) const
-       	 {
-           //Check if data needs to be updated
-       	   if (checkUniformMap(mUniforms, name, &input, 1))
-       	   {
-       	     try
-       	     {
-       	       //Send data to gpu
-       	       glUniform1f(GetUniformLocation(name), input);
-       	     }
-       	     catch (...)
+         void ComputeShader::CheckReload()
+         {
+           //Start building newly changed source (replacing any build still going)
+           if (mReloadPending.exchange(false))
+           {
+             std::string source;
              {
-       	       KL_ERROR("Compute shader just tried to crash when setting uniform")
+               std::lock_guard&ltstd::mutex> lock(mReloadMutex);
+               source = std::move(mReloadSource);
              }
-       	   }
-       	 }
-
-         /*********************************************************************
-          * @brief: Sets a uniforms by name's information
-          * 
-          * @param  name:  Name of the uniform to set
-          * @param  input: uniform information to set (overloaded to different
-          *                types)
-         *********************************************************************/
-       	 void ComputeShader::SetUniform(const std::string& name, std::vector&ltfloat>& input) const
-       	 {
-       	   //Check if data needs to be updated
-       	   if(checkUniformMap(mUniforms, name, input.data(), input.size()))
-       	   {
-       	     try
-       	     {
-       	       //Send data to gpu
-       	       glUniform1fv(GetUniformLocation(name), input.size(), input.data());
-       	     }
-       	     catch (...)
-       	     {
-       	       KL_ERROR("Compute shader just tried to crash when setting uniform")
-       	     }
-       	   }
-       	 }
-
-         /*********************************************************************
-          * @brief: Sets a uniforms by name's information
-          * 
-          * @param  name:  Name of the uniform to set
-          * @param  input: uniform information to set (overloaded to different
-          *                types)
-         *********************************************************************/ 
-       	 void ComputeShader::SetUniform(const std::string& name, std::vector&ltglm::vec2>& input) const
-       	 {
-           //if data needs to be updated
-           if (checkUniformMap(mUniforms, name, reinterpret_cast&ltfloat*>(input.data()), input.size() * 2))
-           {
-             try
+       
+             if (mReloadProgram != 0)
              {
-               //Send to opengl
-               glUniform2fv(GetUniformLocation(name), input.size() * 2, reinterpret_cast&ltfloat*>(input.data()));
+               glDeleteShader(mReloadShader);
+               glDeleteProgram(mReloadProgram);
              }
-             catch (...)
+       
+             mReloadKey = GetProgramCacheKey(source);
+             mReloadProgram = CreateShader(source, &mReloadShader);
+           }
+       
+           //Nothing being built
+           if (mReloadProgram == 0)
+           {
+             return;
+           }
+       
+           //Come back next frame if driver is still working
+           if (GLAD_GL_KHR_parallel_shader_compile)
+           {
+             GLint complete = GL_FALSE;
+             glGetProgramiv(mReloadProgram, GL_COMPLETION_STATUS_KHR, &complete);
+             if (complete == GL_FALSE)
              {
-               KL_ERROR("Compute shader just tried to crash when setting uniform")
+               return;
              }
            }
-       	 }
+       
+           //Shader is no longer needed on our side
+           glDeleteShader(mReloadShader);
+           mReloadShader = 0;
+       
+           //Keep old program if new one failed
+           GLint isLinked = 0;
+           glGetProgramiv(mReloadProgram, GL_LINK_STATUS, &isLinked);
+           if (isLinked == GL_FALSE)
+           {
+             GLint maxLength = 0;
+             glGetProgramiv(mReloadProgram, GL_INFO_LOG_LENGTH, &maxLength);
+             std::vector&ltGLchar> infoLog(maxLength + 1);
+             glGetProgramInfoLog(mReloadProgram, maxLength, &maxLength, &infoLog[0]);
+       
+             KL_ERROR("Reloaded compute shader {} failed, keeping old program \n {}", mFilePath, infoLog.data())
+             glDeleteProgram(mReloadProgram);
+             mReloadProgram = 0;
+             return;
+           }
+       
+           //Swap new program in
+           Wait();
+           ForgetProgram(mComputeShaderID);
+           glDeleteProgram(mComputeShaderID);
+           mComputeShaderID = mReloadProgram;
+           mReloadProgram = 0;
+           ++mReloadCount;
+       
+           //Cache it and find its uniforms
+           mProgramCacheKey = mReloadKey;
+           SaveProgramBinary();
+           ReflectUniforms();
+           ReflectUniformBlock();
+       
+           std::chrono::duration&ltfloat, std::milli> time = std::chrono::steady_clock::now() - mReloadDetected;
+           KL_INFO("Reloaded compute shader {} in {}ms", mFilePath, time.count())
+         }
+       
+         /*********************************************************************
+          * @brief: Gets how many times this shader has been hot reloaded
+          * 
+          * @return Number of successful reloads
+         *********************************************************************/
+         int ComputeShader::GetReloadCount() const
+         {
+           return mReloadCount;
+         }
 
          /*********************************************************************
-          * @brief: Sets a uniforms by name's information
+          * @brief: Starts a named gpu timing scope, everything sent to the gpu
+          *         until EndTiming is timed (usually just a Dispatch), results
+          *         are read a few frames later by CollectTimings
           * 
-          * @param  name:  Name of the uniform to set
-          * @param  input: uniform information to set (overloaded to different
-          *                types)
+          * @param  scope: Name of the scope, must outlive the results being 
+          *                collected (use string literals)
          *********************************************************************/
-       	 void ComputeShader::SetUniform(const std::string& name, std::vector&ltglm::vec4>& input) const
-       	 {
-           //Check if data needs to be updated
-           if (checkUniformMap(mUniforms, name, reinterpret_cast&ltfloat*>(input.data()), input.size() * 4))
+         void ComputeShader::BeginTiming(const char* scope) const
+         {
+           //Grab more queries when the pool runs dry
+           if (mFreeQueries.size() &lt 2)
+           {
+             GLuint queries[32];
+             glGenQueries(32, queries);
+             mFreeQueries.insert(mFreeQueries.end(), queries, queries + 32);
+           }
+       
+           //Mark the start time on the gpu timeline
+           TimingScope timing{ scope, mFreeQueries.back(), 0 };
+           mFreeQueries.pop_back();
+           glQueryCounter(timing.startQuery, GL_TIMESTAMP);
+       
+           mTimingsInFlight.push_back(timing);
+         }
+       
+         /*********************************************************************
+          * @brief: Ends the innermost timing scope still open, scopes can be
+          *         nested, ignored if no scope is open
+         *********************************************************************/
+         void ComputeShader::EndTiming() const
+         {
+           //Open scopes are the ones without an end yet, the last one started is the innermost
+           auto open = std::find_if(mTimingsInFlight.rbegin(), mTimingsInFlight.rend(),
+             [](const TimingScope& timing) { return timing.endQuery == 0; });
+           if (open == mTimingsInFlight.rend())
            {
-             try
+             KL_WARN("EndTiming called on compute shader {} without a matching BeginTiming", mFilePath)
+             return;
+           }
+       
+           //Nested scopes can use up the pool between begin and end
+           if (mFreeQueries.empty())
+           {
+             GLuint queries[32];
+             glGenQueries(32, queries);
+             mFreeQueries.insert(mFreeQueries.end(), queries, queries + 32);
+           }
+       
+           //Mark the end time on the gpu timeline
+           open->endQuery = mFreeQueries.back();
+           mFreeQueries.pop_back();
+           glQueryCounter(open->endQuery, GL_TIMESTAMP);
+         }
+       
+         /*********************************************************************
+          * @brief: Reads back every finished timing scope without waiting on
+          *         the gpu and adds them to the stats, call once a frame
+         *********************************************************************/
+         void ComputeShader::CollectTimings() const
+         {
+           //Scopes are read in the order they began, so stop at the first one still open or running
+           while (!mTimingsInFlight.empty() && mTimingsInFlight.front().endQuery != 0)
+           {
+             TimingScope& timing = mTimingsInFlight.front();
+             GLint available = GL_FALSE;
+             glGetQueryObjectiv(timing.endQuery, GL_QUERY_RESULT_AVAILABLE, &available);
+             if (available == GL_FALSE)
+             {
+               break;
+             }
+       
+             //Get start and end in nanoseconds
+             GLuint64 start = 0;
+             GLuint64 end = 0;
+             glGetQueryObjectui64v(timing.startQuery, GL_QUERY_RESULT, &start);
+             glGetQueryObjectui64v(timing.endQuery, GL_QUERY_RESULT, &end);
+       
+             //Add to the scope's rolling window of samples
+             float milliseconds = (end - start) / 1000000.0f;
+             TimingHistory& history = mTimingHistory[timing.scope];
+             if (history.samples.size() &lt TimingWindow)
+             {
+               history.samples.push_back(milliseconds);
+             }
+             else
              {
-               //Send to opengl
-               glUniform4fv(GetUniformLocation(name), input.size() * 4, reinterpret_cast&ltfloat*>(input.data()));
+               history.samples[history.next] = milliseconds;
              }
-             catch (...)
+             history.next = (history.next + 1) % TimingWindow;
+       
+             //Keep a bounded trace of events for exporting
+             mTraceEvents.push_back(TraceEvent{ timing.scope, start, end - start });
+             if (mTraceEvents.size() > TraceEventLimit)
              {
-               KL_ERROR("Compute shader just tried to crash when setting uniform")
+               mTraceEvents.pop_front();
              }
+       
+             //Queries can be reused
+             mFreeQueries.push_back(timing.startQuery);
+             mFreeQueries.push_back(timing.endQuery);
+             mTimingsInFlight.pop_front();
            }
-       	 }
-        
-         //--------------------------------------------------------------------------------------
-         //Helper functions----------------------------------------------------------------------
-         //--------------------------------------------------------------------------------------
+         }
+       
          /*********************************************************************
-          * @brief: Gets a uniform location from a name
+          * @brief: Gets the stats of a timing scope over its recent samples
           * 
-          * @param  name: Name of the uniform to get
-          * @return The location of the uniform
-        *********************************************************************/
-       	 unsigned int ComputeShader::GetUniformLocation(const std::string& name) const
-       	 {
-       	   //If already in cache
-       	   if (mUniformLocationCache.find(name) != mUniformLocationCache.end())
-       	   {
-             //Return uniform
-             return mUniformLocationCache[name];
-       	   }
-        
-       	   //Find uniform in shader
-       	   int location = glGetUniformLocation(mComputeShaderID, name.c_str());
-       	   if (location == -1)
-       	   {
-       	     KL_WARN("Warning: uniform {} doesn't exist!", name);
-       	   }
-       	   else
-       	   {
-       	     mUniformLocationCache[name] = location;
-       	   }
-       	   return location;
-       	 }
-        
+          * @param  scope: Name of the scope
+          * @return Min, average and 99th percentile gpu time in milliseconds,
+          *         all 0 if the scope has no samples yet
+         *********************************************************************/
+         ComputeShader::TimingStats ComputeShader::GetTimingStats(const std::string& scope) const
+         {
+           TimingStats stats{ 0.0f, 0.0f, 0.0f, 0 };
+           auto found = mTimingHistory.find(scope);
+           if (found == mTimingHistory.end() || found->second.samples.empty())
+           {
+             return stats;
+           }
+       
+           //Min and average
+           std::vector&ltfloat> samples = found->second.samples;
+           stats.count = static_cast&ltint>(samples.size());
+           stats.min = *std::min_element(samples.begin(), samples.end());
+           for (float sample : samples)
+           {
+             stats.average += sample;
+           }
+           stats.average /= stats.count;
+       
+           //99th percentile
+           size_t p99 = (samples.size() * 99) / 100;
+           std::nth_element(samples.begin(), samples.begin() + p99, samples.end());
+           stats.p99 = samples[p99];
+       
+           return stats;
+         }
+       
          /*********************************************************************
-          * @brief: Gets the source code of a compute shader from the filepath 
-          *         of this compute shader object
+          * @brief: Writes the collected timing scopes to a Chrome trace file
+          *         (open in chrome://tracing or Perfetto)
           * 
-          * @return The source code of the compute shader
+          * @param  path: Path of the json file to write
          *********************************************************************/
-       	 std::string ComputeShader::ParseShader()
+         void ComputeShader::WriteChromeTrace(const std::string& path) const
+         {
+           std::ofstream file(path, std::ios::trunc);
+           file &lt&lt "{\"traceEvents\":[";
+       
+           //Trace times are in microseconds, written out in full
+           file &lt&lt std::fixed;
+           bool first = true;
+           for (const TraceEvent& event : mTraceEvents)
+           {
+             //Scope names can be anything the caller passed to BeginTiming
+             file &lt&lt (first ? "" : ",") &lt&lt "\n{\"name\":\"" &lt&lt EscapeJson(event.scope) 
+                  &lt&lt "\",\"cat\":\"compute\",\"ph\":\"X\",\"pid\":0,\"tid\":0,\"ts\":" &lt&lt event.start / 1000.0
+                  &lt&lt ",\"dur\":" &lt&lt event.duration / 1000.0 &lt&lt "}";
+             first = false;
+           }
+       
+           file &lt&lt "\n]}\n";
+         }
+       
+         /********************************************************************* 
+          * @brief: Binds texture to compute shader
+          * 
+          * @param  textureID: Id of texture to bind
+          * @param  index: Index of texture in compute shader
+          * @param  layered: If this texture is layered
+         *********************************************************************/
+       	 void ComputeShader::BindTexture(unsigned int textureID, int index, bool layered) const
        	 {
-       	   //Open file
-       	   std::ifstream stream(mFilePath);
-        
-       	   //While there are new lines in the file
-       	   std::string line;
-       	   std::stringstream ss;
-       	   while (getline(stream, line))
-       	   {
-       	     //Add line to selected string
-       	     ss &lt&lt line &lt&lt '\n';
-       	   }
-        
-       	   //Return formed strings in the struct
-       	   return ss.str();
+           //Textures live on the gpu, cpu kernels have to get images through buffers
+           if (mCpuKernel)
+           {
+             KL_WARN("Warning: cpu compute kernel {} can't bind textures!", mFilePath);
+             return;
+           }
+       
+       	   CachedBindImageTexture(index, textureID, layered);
        	 }
         
          /*********************************************************************
-          * @brief: Compiles a shader from a string
+          * @brief: Makes a buffer and sets the id
           * 
-          * @param  source: The string the shader code is stored in
-          * @return The compiled shader's id
+          * @param  bufferID: Will be filled with id of this buffer
          *********************************************************************/
-       	 unsigned int ComputeShader::CompileShader(std::string source)
+       	 void ComputeShader::GenBuffer(unsigned int* bufferID) const
        	 {
-       	   //Creates id for the shader
-       	   unsigned int id = glCreateShader(GL_COMPUTE_SHADER);
-        
-       	   //Get string as a c string for opengl
-       	   const char* src = source.c_str();
-        
-       	   //Set the shader and compile it
-       	   glShaderSource(id, 1, &src, nullptr);
-       	   glCompileShader(id);
-        
-       #if defined(_DEBUG) || defined(_EDITORRELEASE)
-       	   //Error handling
-       	   int result;
-       	   glGetShaderiv(id, GL_COMPILE_STATUS, &result);
-       	   if (result == GL_FALSE)
-       	   {
-       	     //Get length of message
-       	     int length;
-       	     glGetShaderiv(id, GL_INFO_LOG_LENGTH, &length);
-        
-       	     //Allocate memory for message
-       	     char* message = (char*)_malloca(length * sizeof(char));
-        
-       	     glGetShaderInfoLog(id, length, &length, message);
-       	     KL_CRITICAL("Failed to compile compute shader! \n {}", message)
-       	     glDeleteShader(id);
-       	     return 0;
-       	   }
-        
-       	   KL_INFO("Successfully compiled compute shader")
-       #endif
-        
-       	   return id;
+           //Cpu backend buffers are just memory
+           if (mCpuKernel)
+           {
+             *bufferID = sNextCpuBuffer++;
+             mCpuBuffers[*bufferID];
+             return;
+           }
+       
+       	   //Generate buffer
+       	   glGenBuffers(1, bufferID);
+       	   CachedBindBuffer(GL_SHADER_STORAGE_BUFFER, *bufferID);
        	 }
         
          /*********************************************************************
-          * @brief: Creates a program from a shader string
+          * @brief: Binds a buffer's data to the compute shader
           * 
-          * @param  source: A compute shader in a string
-          * @return The Id of the created shader program
+          * @param  bufferID: Id of buffer to bind
+          * @param  index: Index of buffer in compute shader
+          * @param  data: Array data to bind
+          * @param  size: Size of array to bind
+          * @param  flag: Flag for buffer
          *********************************************************************/
-       	 unsigned int ComputeShader::CreateShader(std::string source)
+       	 void ComputeShader::BindBuffer(unsigned int* bufferID, 
+                                        int index, 
+                                        float* data, 
+                                        int size, 
+                                        ComputeShader::flags flag) const
        	 {
-       	   //Create ids for shaders and program
-       	   unsigned int program = glCreateProgram();
-       	   unsigned int cs = CompileShader(source);
-        
-       	   //Attach shaders 
-       	   glAttachShader(program, cs);
-       	   glLinkProgram(program);
-        
-       #if defined(_DEBUG) || defined(_EDITORRELEASE)
-       	   //Check for successful linkage
-       	   GLint isLinked = 0;
-       	   glGetProgramiv(program, GL_LINK_STATUS, &isLinked);
-       	   if (isLinked == GL_FALSE)
-       	   {
-       	     GLint maxLength = 0;
-       	     glGetProgramiv(program, GL_INFO_LOG_LENGTH, &maxLength);
-        
-       	     //The maxLength includes the NULL character
-       	     std::vector&ltGLchar> infoLog(maxLength);
-       	     glGetProgramInfoLog(program, maxLength, &maxLength, &infoLog[0]);
-        
-       	     KL_CRITICAL("Failed to link compute shader! \n {}", infoLog.data())
-        
-       	     //The program is useless now. So delete it.
-       	     glDeleteProgram(program);
-        
-       	     //Exit with failure.
-       	     return 0;
-       	   }
-        
-       	   KL_INFO("Successfully linked compute shader")
-       #endif
-        
-       	   //Finish attaching shaders
-       	   glValidateProgram(program);
-        
-       	   //Can now delete shaders on our side (OpenGL has them)
-       	   glDeleteShader(cs);
-        
-       	   return program;
+           GpuBuffer&ltfloat>(*this, bufferID).Bind(index, data, size, flag);
        	 }
-        
+       
          /*********************************************************************
-          * @brief: Checks if passed uniform needs to be send to gpu based on
-          *         map of saved old states, updates map as well if data is
-          *         different
+          * @brief: Binds a buffer's data to the compute shader as raw bytes,
+          *         GpuBuffer&ltT> (and BindBuffer through it) uses this so 
+          *         structs go up without being repacked into floats first
           * 
-          * @param  map: Refernece to the map to look through
-          * @param  name: Name of the uniform
-          * @param  input: Array of values that is the uniform data
-          * @param  count: length of input
-          * @return True if this uniform needs to be resent to the gpu
+          * @param  bufferID: Id of buffer to bind
+          * @param  index: Index of buffer in compute shader
+          * @param  data: Data to bind
+          * @param  bytes: Size of data in bytes
+          * @param  flag: Flag for buffer
          *********************************************************************/
-       	 template &lttypename mapType, typename mapValue>
-       	 bool ComputeShader::checkUniformMap(mapType& map, std::string name, mapValue* input, int count) const
-       	 {
-       	   //If not in map
-       	   if (map.find(name) == map.end())
-       	   {
-       	     //Save value in map 
-       	     mapValue* inputCopy = new  mapValue[count];
-       	     for (int i = 0; i &lt count; ++i)
-       	       inputCopy[i] = input[i];
-       	     map.emplace(name, std::pair&ltmapValue*, int>(inputCopy, count));
-        
-       	     //Uniform needs to be updated
-       	     return true;
-       	   }
-       	   else
-       	   {
-       	     //Check if counts dont match
-       	     if (map[name].second != count)
-       	     {
-       	       //Save value in map 
-       	       mapValue* inputCopy = new mapValue[count];
-       	       for (int i = 0; i &lt count; ++i)
-       	         inputCopy[i] = input[i];
-       	       delete[] map[name].first;
-       	       map[name] = std::pair&ltmapValue*, int>(inputCopy, count);
-        
-       	       //Uniform needs to be updated
-       	       return true;
-       	     }
-       	     else
-       	     {
-       	       //Check if values dont match
-       	       bool matching = true;
-       	       for (int i = 0; i &lt count; ++i)
-       	       {
-       	         if (map[name].first[i] != input[i])
-       	         {
-       	           matching = false;
+         void ComputeShader::BindBufferBytes(unsigned int* bufferID, 
+                                             int index, 
+                                             const void* data, 
+                                             size_t bytes, 
+                                             ComputeShader::flags flag) const
+         {
+           //Cpu backend copies into its buffer and points the binding at it
+           if (mCpuKernel)
+           {
+             std::vector&ltunsigned char>& buffer = mCpuBuffers[*bufferID];
+             buffer.resize(bytes);
+             if (data)
+             {
+               std::memcpy(buffer.data(), data, bytes);
+             }
+             mCpuBindings[index] = *bufferID;
+             return;
+           }
+       
+       	   CachedBindBuffer(GL_SHADER_STORAGE_BUFFER, *bufferID);
         
-       	           //Update value in map
-       	           map[name].first[i] = input[i];
-       	         }
-       	       }
+       	   //Set buffer data, respecifying the whole store lets the driver orphan it instead of stalling on a dispatch still reading it
+       	   glBufferData(GL_SHADER_STORAGE_BUFFER, bytes, data, flag);
         
-       	       if (!matching)
-       	       {
-       	         //Uniform needs to be updated
-       	         return true;
-               }
+       	   //Send data to compute
+       	   CachedBindBufferBase(GL_SHADER_STORAGE_BUFFER, index, *bufferID);
+         }
+       
+         /*********************************************************************
+          * @brief: Overwrites part of a buffer without touching the rest, so
+          *         only the elements that changed get sent to the gpu
+          * 
+          * @param  bufferID: Id of buffer to update
+          * @param  offset: Byte offset to start writing at
+          * @param  data: Data to write
+          * @param  bytes: Size of data in bytes
+         *********************************************************************/
+         void ComputeShader::UpdateBufferBytes(unsigned int* bufferID, size_t offset, const void* data, size_t bytes) const
+         {
+           //Cpu backend writes straight into its buffer
+           if (mCpuKernel)
+           {
+             std::vector&ltunsigned char>& buffer = mCpuBuffers[*bufferID];
+             if (offset + bytes &lt= buffer.size())
+             {
+               std::memcpy(buffer.data() + offset, data, bytes);
              }
-       	   }
+             return;
+           }
+       
+           CachedBindBuffer(GL_SHADER_STORAGE_BUFFER, *bufferID);
+           glBufferSubData(GL_SHADER_STORAGE_BUFFER, offset, bytes, data);
+         }
+       
+         /*********************************************************************
+          * @brief: Copies part of one buffer into another on the gpu, the 
+          *         data never comes back to the cpu
+          * 
+          * @param  sourceID: Id of buffer to copy from
+          * @param  destinationID: Id of buffer to copy to
+          * @param  sourceOffset: Byte offset to start reading at
+          * @param  destinationOffset: Byte offset to start writing at
+          * @param  bytes: Number of bytes to copy
+         *********************************************************************/
+         void ComputeShader::CopyBufferBytes(unsigned int* sourceID, 
+                                             unsigned int* destinationID, 
+                                             size_t sourceOffset, 
+                                             size_t destinationOffset, 
+                                             size_t bytes) const
+         {
+           //Cpu backend copies between its buffers
+           if (mCpuKernel)
+           {
+             const std::vector&ltunsigned char>& source = mCpuBuffers[*sourceID];
+             std::vector&ltunsigned char>& destination = mCpuBuffers[*destinationID];
+             if (sourceOffset + bytes &lt= source.size() && destinationOffset + bytes &lt= destination.size())
+             {
+               std::memmove(destination.data() + destinationOffset, source.data() + sourceOffset, bytes);
+             }
+             return;
+           }
+       
+           //Copy targets leave the storage binding alone
+           CachedBindBuffer(GL_COPY_READ_BUFFER, *sourceID);
+           CachedBindBuffer(GL_COPY_WRITE_BUFFER, *destinationID);
+           glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, sourceOffset, destinationOffset, bytes);
+         }
         
-       	   //Uniform has not changed
-      	   return false;
+         /*********************************************************************
+          * @brief: Reads data from a buffer on the pu
+          * 
+          * @param  bufferID: Id of buffer to read from
+          * @param  data: Will be filled with read data
+          * @param  size: Size of array to fill
+         *********************************************************************/
+       	 void ComputeShader::ReadBuffer(unsigned int* bufferID, float** data, int size) const
+       	 {
+           GpuBuffer&ltfloat>(*this, bufferID).Read(*data, size);
        	 }
+       
+         /*********************************************************************
+          * @brief: Maps a buffer for reading so results can be used in place
+          *         without copying them out first (blocks until the gpu is 
+          *         done with it), call UnmapBuffer when finished
+          * 
+          * @param  bufferID: Id of buffer to read from
+          * @param  bytes: Number of bytes to map
+          * @return View of the buffer's bytes, empty if mapping failed
+         *********************************************************************/
+         std::span&ltconst std::byte> ComputeShader::MapBufferBytes(unsigned int* bufferID, size_t bytes) const
+         {
+           //Cpu backend results are already in memory
+           if (mCpuKernel)
+           {
+             const std::vector&ltunsigned char>& buffer = mCpuBuffers[*bufferID];
+             return std::span&ltconst std::byte>(reinterpret_cast&ltconst std::byte*>(buffer.data()), std::min(buffer.size(), bytes));
+           }
+       
+       	   CachedBindBuffer(GL_SHADER_STORAGE_BUFFER, *bufferID);
+        
+       	   //Get data from compute (blocks until the gpu is done with it)
+           auto start = std::chrono::steady_clock::now();
+       	   void* mapped = glMapBufferRange(GL_SHADER_STORAGE_BUFFER, 0, bytes, GL_MAP_READ_BIT);
+           mStallTime += std::chrono::duration&ltfloat, std::milli>(std::chrono::steady_clock::now() - start).count();
+       
+           if (mapped == nullptr)
+           {
+             return {};
+           }
+       
+           return std::span&ltconst std::byte>(static_cast&ltconst std::byte*>(mapped), bytes);
+         }
+       
+         /*********************************************************************
+          * @brief: Unmaps a buffer mapped by MapBufferBytes, any view of it
+          *         is no longer valid after this
+          * 
+          * @param  bufferID: Id of buffer to unmap
+         *********************************************************************/
+         void ComputeShader::UnmapBuffer(unsigned int* bufferID) const
+         {
+           //Cpu backend never mapped anything
+           if (mCpuKernel)
+           {
+             return;
+           }
+       
+           CachedBindBuffer(GL_SHADER_STORAGE_BUFFER, *bufferID);
+           glUnmapBuffer(GL_SHADER_STORAGE_BUFFER);
+         }
+       
+         /*********************************************************************
+          * @brief: Checks that a struct matches the std430 array stride the 
+          *         shader was linked with, catches layouts the compile time 
+          *         checks in GpuBuffer&ltT> can't see (like a missing pad)
+          * 
+          * @param  variable: Name of the buffer's array, e.g. "Lights.data"
+          * @param  elementSize: sizeof the struct used for each element
+          * @return If the strides match (true if the shader has no such array)
+         *********************************************************************/
+         bool ComputeShader::CheckBufferStride(const std::string& variable, size_t elementSize) const
+         {
+           //Cpu kernels use the struct directly
+           if (mCpuKernel)
+           {
+             return true;
+           }
+       
+           Wait();
+       
+           //Arrays of structs are named by their first member, e.g. "Lights.data[0].position"
+           GLuint resource = glGetProgramResourceIndex(mComputeShaderID, GL_BUFFER_VARIABLE, (variable + "[0]").c_str());
+           if (resource == GL_INVALID_INDEX)
+           {
+             GLint count = 0;
+             glGetProgramInterfaceiv(mComputeShaderID, GL_BUFFER_VARIABLE, GL_ACTIVE_RESOURCES, &count);
+       
+             //Find any member of the array instead
+             std::string prefix = variable + "[0].";
+             for (GLint i = 0; i &lt count && resource == GL_INVALID_INDEX; ++i)
+             {
+               char name[256];
+               glGetProgramResourceName(mComputeShaderID, GL_BUFFER_VARIABLE, i, sizeof(name), nullptr, name);
+               if (std::strncmp(name, prefix.c_str(), prefix.size()) == 0)
+               {
+                 resource = i;
+               }
+             }
+       
+             if (resource == GL_INVALID_INDEX)
+             {
+               return true;
+             }
+           }
+       
+           GLenum property = GL_TOP_LEVEL_ARRAY_STRIDE;
+           GLint stride = 0;
+           glGetProgramResourceiv(mComputeShaderID, GL_BUFFER_VARIABLE, resource, 1, &property, 1, nullptr, &stride);
+       
+           if (stride != 0 && static_cast&ltsize_t>(stride) != elementSize)
+           {
+             KL_ERROR("Error: {} in {} has a stride of {} bytes but the struct is {} bytes!", variable, mFilePath, stride, elementSize);
+             return false;
+           }
+       
+           return true;
+         }
+        
+         /*********************************************************************
+          * @brief: Deletes a buffer created by GenBuffer
+          * 
+          * @param  bufferID: Id of buffer to delete
+         *********************************************************************/
+       	 void ComputeShader::DeleteBuffer(unsigned int* bufferID) const
+       	 {
+           //Cpu backend just frees the memory
+           if (mCpuKernel)
+           {
+             mCpuBuffers.erase(*bufferID);
+             return;
+           }
+       
+       	   //Delete buffer
+       	   ForgetBuffer(*bufferID);
+       	   glDeleteBuffers(1, bufferID);
+       	 }
+
+         /*********************************************************************
+          * @brief: Makes a persistently mapped buffer split into 
+          *         RingBufferCount slots, the cpu writes one slot while the 
+          *         gpu still uses the others so neither side has to wait
+          * 
+          * @param  buffer: Will be filled with the ring buffer's info
+          * @param  size: Number of floats in each slot
+         *********************************************************************/
+         void ComputeShader::GenRingBuffer(RingBuffer* buffer, int size) const
+         {
+           //Storage never moves, so it can stay mapped for its whole life
+           GLbitfield flags = GL_MAP_READ_BIT | GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+           GLsizeiptr bytes = sizeof(float) * size * RingBufferCount;
+       
+           //Generate immutable storage and map it once
+           glGenBuffers(1, &buffer->id);
+           CachedBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer->id);
+           glBufferStorage(GL_SHADER_STORAGE_BUFFER, bytes, nullptr, flags);
+           buffer->mapped = static_cast&ltfloat*>(glMapBufferRange(GL_SHADER_STORAGE_BUFFER, 0, bytes, flags));
+           buffer->size = size;
+           buffer->slot = 0;
+       
+           //No slot is in use by the gpu yet
+           for (int i = 0; i &lt RingBufferCount; ++i)
+           {
+             buffer->fences[i] = nullptr;
+           }
+         }
+       
+         /*********************************************************************
+          * @brief: Gets the slot of a ring buffer the cpu can write this 
+          *         frame's data straight into, only waits if the gpu is still
+          *         using it from RingBufferCount frames ago
+          * 
+          * @param  buffer: Ring buffer to write to
+          * @return Pointer to the current slot's floats
+         *********************************************************************/
+         float* ComputeShader::GetRingSlot(RingBuffer* buffer) const
+         {
+           WaitForFence(&buffer->fences[buffer->slot]);
+           return buffer->mapped + buffer->slot * buffer->size;
+         }
+       
+         /*********************************************************************
+          * @brief: Binds the current slot of a ring buffer to the compute 
+          *         shader, no data is copied since the slot is already mapped
+          * 
+          * @param  buffer: Ring buffer to bind
+          * @param  index: Index of buffer in compute shader
+         *********************************************************************/
+         void ComputeShader::BindRingBuffer(RingBuffer* buffer, int index) const
+         {
+           GLsizeiptr bytes = sizeof(float) * buffer->size;
+           CachedBindBufferRange(GL_SHADER_STORAGE_BUFFER, index, buffer->id, bytes * buffer->slot, bytes);
+         }
+       
+         /*********************************************************************
+          * @brief: Marks the end of the gpu's work on the current slot of a
+          *         ring buffer and moves on to the next one, call after the
+          *         dispatches using it
+          * 
+          * @param  buffer: Ring buffer to advance
+         *********************************************************************/
+         void ComputeShader::AdvanceRingBuffer(RingBuffer* buffer) const
+         {
+           //Make gpu writes visible to the mapping before the fence signals
+           glMemoryBarrier(GL_CLIENT_MAPPED_BUFFER_BARRIER_BIT);
+       
+           //The slot can still have a fence GetRingSlot never waited on, the new one covers everything it did
+           if (buffer->fences[buffer->slot] != nullptr)
+           {
+             glDeleteSync(buffer->fences[buffer->slot]);
+           }
+           buffer->fences[buffer->slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+       
+           buffer->slot = (buffer->slot + 1) % RingBufferCount;
+         }
+       
+         /*********************************************************************
+          * @brief: Reads back the newest slot of a ring buffer the gpu has 
+          *         finished with, never waits, the pointer stays valid until
+          *         the next AdvanceRingBuffer
+          * 
+          * @param  buffer: Ring buffer to read from
+          * @return Pointer to the finished slot's floats, nullptr if the gpu
+          *         has not finished any slot yet
+         *********************************************************************/
+         const float* ComputeShader::ReadRingBuffer(RingBuffer* buffer) const
+         {
+           //Check slots from newest to oldest, skipping the current one since GetRingSlot hands it out for writing
+           for (int i = 1; i &lt RingBufferCount; ++i)
+           {
+             int slot = (buffer->slot + RingBufferCount - i) % RingBufferCount;
+             GLsync fence = buffer->fences[slot];
+       
+             //Slot has not been submitted yet
+             if (fence == nullptr)
+             {
+               continue;
+             }
+       
+             //Poll without waiting
+             GLenum result = glClientWaitSync(fence, 0, 0);
+             if (result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED)
+             {
+               return buffer->mapped + slot * buffer->size;
+             }
+           }
+       
+           return nullptr;
+         }
+       
+         /*********************************************************************
+          * @brief: Deletes a ring buffer created by GenRingBuffer
+          * 
+          * @param  buffer: Ring buffer to delete
+         *********************************************************************/
+         void ComputeShader::DeleteRingBuffer(RingBuffer* buffer) const
+         {
+           //Let go of fences
+           for (int i = 0; i &lt RingBufferCount; ++i)
+           {
+             if (buffer->fences[i] != nullptr)
+             {
+               glDeleteSync(buffer->fences[i]);
+               buffer->fences[i] = nullptr;
+             }
+           }
+       
+           //Unmap and delete buffer
+           CachedBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer->id);
+           glUnmapBuffer(GL_SHADER_STORAGE_BUFFER);
+           ForgetBuffer(buffer->id);
+           glDeleteBuffers(1, &buffer->id);
+           buffer->mapped = nullptr;
+         }
+       
+         /*********************************************************************
+          * @brief: Gets how long the cpu has stalled waiting on the gpu for
+          *         buffers since the last call, call once a frame
+          * 
+          * @return Milliseconds spent waiting
+         *********************************************************************/
+         float ComputeShader::GetBufferStallTime() const
+         {
+           float stall = mStallTime;
+           mStallTime = 0.0f;
+           return stall;
+         }
+
+         /*********************************************************************
+          * @brief: Unbinds shader
+         *********************************************************************/
+       	 void ComputeShader::Unbind() const
+       	 {
+           //Cpu backend never bound anything
+           if (mCpuKernel)
+           {
+             return;
+           }
+       
+           //Leave this shader bound until something actually draws
+           if (sStateCache.deferRasterRebind)
+           {
+             sStateCache.rasterPending = true;
+             return;
+           }
+       
+       	   //Go back to image drawing shader (binding it replaces this one, no need to bind 0 first)
+       	   RendererGetShader()->Bind();
+           sStateCache.program = GLStateCache::Unknown;
+           sStateCache.rasterPending = false;
+       	 }
+       
+         /*********************************************************************
+          * @brief: Binds the image drawing shader if an Unbind was deferred,
+          *         call before drawing when deferred rebinds are on
+         *********************************************************************/
+         void ComputeShader::RestoreRasterShader()
+         {
+           if (sStateCache.rasterPending)
+           {
+             RendererGetShader()->Bind();
+             sStateCache.program = GLStateCache::Unknown;
+             sStateCache.rasterPending = false;
+           }
+         }
+       
+         /*********************************************************************
+          * @brief: Sets if Unbind should wait to rebind the image drawing 
+          *         shader until RestoreRasterShader, so back to back compute
+          *         passes don't swap programs in between
+          * 
+          * @param  defer: If rebinds should be deferred
+         *********************************************************************/
+         void ComputeShader::SetDeferRasterRebind(bool defer)
+         {
+           sStateCache.deferRasterRebind = defer;
+       
+           //Turning it off shouldn't leave the wrong shader bound
+           if (!defer)
+           {
+             RestoreRasterShader();
+           }
+         }
+       
+         /*********************************************************************
+          * @brief: Turns skipping redundant GL binds on or off, only turn it
+          *         on if code outside of ComputeShader calls 
+          *         InvalidateStateCache after changing bindings (dispatch 
+          *         recorder batches start from a fresh cache either way)
+          * 
+          * @param  enabled: If redundant binds should be skipped
+         *********************************************************************/
+         void ComputeShader::SetStateCacheEnabled(bool enabled)
+         {
+           sStateCache.enabled = enabled;
+           InvalidateStateCache();
+         }
+       
+         /*********************************************************************
+          * @brief: Forgets all cached GL state, call after code outside of 
+          *         ComputeShader changes programs or buffer bindings
+         *********************************************************************/
+         void ComputeShader::InvalidateStateCache()
+         {
+           sStateCache.program = GLStateCache::Unknown;
+           sStateCache.buffers.clear();
+           sStateCache.ranges.clear();
+           sStateCache.images.clear();
+         }
+       
+         /*********************************************************************
+          * @brief: Gets how many GL bind calls went through to the driver and
+          *         how many were skipped as redundant since the last call
+          * 
+          * @param  issued: Will be filled with number of calls made
+          * @param  skipped: Will be filled with number of calls skipped
+         *********************************************************************/
+         void ComputeShader::GetStateCallCounts(int* issued, int* skipped)
+         {
+           *issued = sStateCache.issued;
+           *skipped = sStateCache.skipped;
+           sStateCache.issued = 0;
+           sStateCache.skipped = 0;
+         }
+        
+         /*********************************************************************
+          * @brief: Sets a uniforms by name's information, prefer getting a
+          *         handle once with GetUniformHandle and setting by that
+          *         (names are looked up without being copied into strings)
+          * 
+          * @param  name:  Name of the uniform to set
+          * @param  input: uniform information to set (overloaded to different
+          *                types)
+         *********************************************************************/
+       	 void ComputeShader::SetUniform(std::string_view name, float input) const
+       	 {
+           SetUniform(GetUniformHandle(name), input);
+       	 }
+
+         /*********************************************************************
+          * @brief: Sets a uniforms by name's information, prefer getting a
+          *         handle once with GetUniformHandle and setting by that
+          *         (names are looked up without being copied into strings)
+          * 
+          * @param  name:  Name of the uniform to set
+          * @param  input: uniform information to set (overloaded to different
+          *                types)
+         *********************************************************************/
+       	 void ComputeShader::SetUniform(std::string_view name, std::vector&ltfloat>& input) const
+       	 {
+           SetUniform(GetUniformHandle(name), input);
+       	 }
+
+         /*********************************************************************
+          * @brief: Sets a uniforms by name's information, prefer getting a
+          *         handle once with GetUniformHandle and setting by that
+          *         (names are looked up without being copied into strings)
+          * 
+          * @param  name:  Name of the uniform to set
+          * @param  input: uniform information to set (overloaded to different
+          *                types)
+         *********************************************************************/
+       	 void ComputeShader::SetUniform(std::string_view name, std::vector&ltglm::vec2>& input) const
+       	 {
+           SetUniform(GetUniformHandle(name), input);
+       	 }
+
+         /*********************************************************************
+          * @brief: Sets a uniforms by name's information, prefer getting a
+          *         handle once with GetUniformHandle and setting by that
+          *         (names are looked up without being copied into strings)
+          * 
+          * @param  name:  Name of the uniform to set
+          * @param  input: uniform information to set (overloaded to different
+          *                types)
+         *********************************************************************/
+       	 void ComputeShader::SetUniform(std::string_view name, std::vector&ltglm::vec4>& input) const
+       	 {
+           SetUniform(GetUniformHandle(name), input);
+       	 }
+
+         /*********************************************************************
+          * @brief: Gets a handle for a uniform by name, look this up once and
+          *         keep it, setting by handle skips the name lookup
+          * 
+          * @param  name: Name of the uniform (arrays without the [0]), a 
+          *                single element can be picked with name[index]
+          * @return Handle of the uniform, -1 if it doesn't exist
+         *********************************************************************/
+         int ComputeShader::GetUniformHandle(std::string_view name) const
+         {
+           //Uniforms are only known once the shader is built
+           Wait();
+       
+           auto found = mUniformHandles.find(name);
+       
+           //Array elements get their own handle the first time they are asked for
+           if (!mCpuKernel && found == mUniformHandles.end())
+           {
+             found = AddUniformElement(name);
+           }
+       
+           //Cpu kernels have no reflection, so uniforms get a handle the first time they are asked for
+           if (mCpuKernel && found == mUniformHandles.end())
+           {
+             mCpuUniforms.emplace_back();
+             found = mUniformHandles.emplace(name, static_cast&ltint>(mCpuUniforms.size()) - 1).first;
+           }
+       
+           if (found == mUniformHandles.end())
+           {
+             KL_WARN("Warning: uniform {} doesn't exist!", name);
+             return -1;
+           }
+       
+           return found->second;
+         }
+       
+         /*********************************************************************
+          * @brief: Gives an element of a uniform array, like "lights[2]", its
+          *         own handle, it shares the array's shadow values so setting
+          *         either one keeps the other's shadow right
+          * 
+          * @param  name: Name of the uniform with a subscript
+          * @return Iterator to the new handle, end if name is not an element
+          *         of a known array
+         *********************************************************************/
+         ComputeShader::UniformHandles::iterator ComputeShader::AddUniformElement(std::string_view name) const
+         {
+           //Split name[index] into the array and the index (atoi stops at the ])
+           size_t bracket = name.find('[');
+           if (bracket == std::string_view::npos || name.back() != ']')
+           {
+             return mUniformHandles.end();
+           }
+           auto array = mUniformHandles.find(name.substr(0, bracket));
+           int index = std::atoi(name.data() + bracket + 1);
+           if (array == mUniformHandles.end())
+           {
+             return mUniformHandles.end();
+           }
+       
+           //Driver knows the element's location, and fails for indices past the end
+           UniformSlot element = mUniformSlots[array->second];
+           element.location = glGetUniformLocation(mComputeShaderID, std::string(name).c_str());
+           if (element.location == -1 || index * element.components >= element.size)
+           {
+             return mUniformHandles.end();
+           }
+       
+           //Element's shadow starts partway into the array's
+           element.offset += index * element.components;
+           element.size -= index * element.components;
+           element.set = false;
+           mUniformSlots.push_back(element);
+           return mUniformHandles.emplace(name, static_cast&ltint>(mUniformSlots.size()) - 1).first;
+         }
+       
+         /*********************************************************************
+          * @brief: Sets a uniform by handle's information
+          * 
+          * @param  handle: Handle of the uniform to set (from GetUniformHandle)
+          * @param  input: uniform information to set (overloaded to different
+          *                types)
+         *********************************************************************/
+         void ComputeShader::SetUniform(int handle, float input) const
+         {
+           //Check if data needs to be updated
+           if (checkUniformSlot(handle, &input, 1))
+           {
+             //Send data to gpu
+             glUniform1f(mUniformSlots[handle].location, input);
+           }
+         }
+       
+         /*********************************************************************
+          * @brief: Sets a uniform by handle's information
+          * 
+          * @param  handle: Handle of the uniform to set (from GetUniformHandle)
+          * @param  input: uniform information to set (overloaded to different
+          *                types)
+         *********************************************************************/
+         void ComputeShader::SetUniform(int handle, std::vector&ltfloat>& input) const
+         {
+           //Check if data needs to be updated
+           if (checkUniformSlot(handle, input.data(), static_cast&ltint>(input.size())))
+           {
+             //Send data to gpu
+             glUniform1fv(mUniformSlots[handle].location, static_cast&ltGLsizei>(input.size()), input.data());
+           }
+         }
+       
+         /*********************************************************************
+          * @brief: Sets a uniform by handle's information
+          * 
+          * @param  handle: Handle of the uniform to set (from GetUniformHandle)
+          * @param  input: uniform information to set (overloaded to different
+          *                types)
+         *********************************************************************/
+         void ComputeShader::SetUniform(int handle, std::vector&ltglm::vec2>& input) const
+         {
+           //Check if data needs to be updated
+           if (checkUniformSlot(handle, reinterpret_cast&ltfloat*>(input.data()), static_cast&ltint>(input.size()) * 2))
+           {
+             //Send data to gpu
+             glUniform2fv(mUniformSlots[handle].location, static_cast&ltGLsizei>(input.size()), reinterpret_cast&ltfloat*>(input.data()));
+           }
+         }
+       
+         /*********************************************************************
+          * @brief: Sets a uniform by handle's information
+          * 
+          * @param  handle: Handle of the uniform to set (from GetUniformHandle)
+          * @param  input: uniform information to set (overloaded to different
+          *                types)
+         *********************************************************************/
+         void ComputeShader::SetUniform(int handle, std::vector&ltglm::vec4>& input) const
+         {
+           //Check if data needs to be updated
+           if (checkUniformSlot(handle, reinterpret_cast&ltfloat*>(input.data()), static_cast&ltint>(input.size()) * 4))
+           {
+             //Send data to gpu
+             glUniform4fv(mUniformSlots[handle].location, static_cast&ltGLsizei>(input.size()), reinterpret_cast&ltfloat*>(input.data()));
+           }
+         }
+       
+         /*********************************************************************
+          * @brief: Gets where a member of this shader's uniform block lives
+          *         in the block, look this up once and keep it
+          * 
+          * @param  name: Name of the block member
+          * @return Offset and array stride of the member, offset is -1 if 
+          *         the block has no such member
+         *********************************************************************/
+         ComputeShader::BlockUniform ComputeShader::GetBlockUniform(const std::string& name) const
+         {
+           //Block layout is only known once the shader is built
+           Wait();
+       
+           auto found = mBlockUniforms.find(name);
+           if (found == mBlockUniforms.end())
+           {
+             KL_WARN("Warning: block uniform {} doesn't exist!", name);
+             return BlockUniform{ -1, 0 };
+           }
+       
+           return found->second;
+         }
+       
+         /*********************************************************************
+          * @brief: Sets a uniform block member's information, only writes to
+          *         the cpu side copy of the block, it gets sent with the next
+          *         dispatch
+          * 
+          * @param  uniform: Block member to set (from GetBlockUniform)
+          * @param  input: uniform information to set (overloaded to different
+          *                types)
+         *********************************************************************/
+         void ComputeShader::SetBlockUniform(BlockUniform uniform, float input) const
+         {
+           writeUniformBlock(uniform, &input, 1, 1);
+         }
+       
+         /*********************************************************************
+          * @brief: Sets a uniform block member's information, only writes to
+          *         the cpu side copy of the block, it gets sent with the next
+          *         dispatch
+          * 
+          * @param  uniform: Block member to set (from GetBlockUniform)
+          * @param  input: uniform information to set (overloaded to different
+          *                types)
+         *********************************************************************/
+         void ComputeShader::SetBlockUniform(BlockUniform uniform, std::vector&ltfloat>& input) const
+         {
+           writeUniformBlock(uniform, input.data(), static_cast&ltint>(input.size()), 1);
+         }
+       
+         /*********************************************************************
+          * @brief: Sets a uniform block member's information, only writes to
+          *         the cpu side copy of the block, it gets sent with the next
+          *         dispatch
+          * 
+          * @param  uniform: Block member to set (from GetBlockUniform)
+          * @param  input: uniform information to set (overloaded to different
+          *                types)
+         *********************************************************************/
+         void ComputeShader::SetBlockUniform(BlockUniform uniform, std::vector&ltglm::vec2>& input) const
+         {
+           writeUniformBlock(uniform, reinterpret_cast&ltfloat*>(input.data()), static_cast&ltint>(input.size()), 2);
+         }
+       
+         /*********************************************************************
+          * @brief: Sets a uniform block member's information, only writes to
+          *         the cpu side copy of the block, it gets sent with the next
+          *         dispatch
+          * 
+          * @param  uniform: Block member to set (from GetBlockUniform)
+          * @param  input: uniform information to set (overloaded to different
+          *                types)
+         *********************************************************************/
+         void ComputeShader::SetBlockUniform(BlockUniform uniform, std::vector&ltglm::vec4>& input) const
+         {
+           writeUniformBlock(uniform, reinterpret_cast&ltfloat*>(input.data()), static_cast&ltint>(input.size()), 4);
+         }
+        
+         //--------------------------------------------------------------------------------------
+         //Helper functions----------------------------------------------------------------------
+         //--------------------------------------------------------------------------------------
+         /*********************************************************************
+          * @brief: Gets the source code of a compute shader from the filepath 
+          *         of this compute shader object
+          * 
+          * @return The source code of the compute shader
+         *********************************************************************/
+       	 std::string ComputeShader::ParseShader()
+       	 {
+           //Get source with all includes pasted in
+           std::vector&ltstd::string> dependencies;
+           std::string source = PreprocessShader(mFilePath, dependencies, 0);
+       
+           //Remember which files to watch for hot reloading
+           std::lock_guard&ltstd::mutex> lock(mReloadMutex);
+           mDependencies = dependencies;
+       
+       	   return source;
+       	 }
+       
+         /*********************************************************************
+          * @brief: Reads a shader file, replacing every #include "file" line
+          *         with that file's (also preprocessed) source, results are
+          *         cached until one of the files they came from changes
+          * 
+          * @param  path: Path of the file to read
+          * @param  dependencies: Gets every file read added to it
+          * @param  depth: How many includes deep this file is, used to stop
+          *                include loops
+          * @return The source code with all includes resolved
+         *********************************************************************/
+         std::string ComputeShader::PreprocessShader(const std::string& path, std::vector&ltstd::string>& dependencies, int depth)
+         {
+           //Include loop
+           if (depth > 16)
+           {
+             KL_ERROR("Compute shader includes nested too deep (include loop?) at {}", path)
+             return "";
+           }
+       
+           //Use cached result if none of the files it came from have changed
+           {
+             std::lock_guard&ltstd::mutex> lock(sPreprocessMutex);
+             auto cached = sPreprocessedSources.find(path);
+             if (cached != sPreprocessedSources.end())
+             {
+               bool current = true;
+               for (const auto& file : cached->second.files)
+               {
+                 std::error_code error;
+                 current = current && std::filesystem::last_write_time(file.first, error) == file.second;
+               }
+       
+               if (current)
+               {
+                 for (const auto& file : cached->second.files)
+                 {
+                   dependencies.push_back(file.first);
+                 }
+                 return cached->second.source;
+               }
+             }
+           }
+       
+           //Start this file's entry
+           PreprocessedSource result;
+           std::error_code error;
+           result.files.emplace_back(path, std::filesystem::last_write_time(path, error));
+       
+       	   //Open file
+       	   std::ifstream stream(path);
+           std::filesystem::path folder = std::filesystem::path(path).parent_path();
+        
+       	   //While there are new lines in the file
+       	   std::string line;
+       	   std::stringstream ss;
+       	   while (getline(stream, line))
+       	   {
+             //Paste in included files (found relative to this file)
+             size_t include = line.find("#include");
+             size_t open = line.find('"');
+             size_t close = line.rfind('"');
+             if (include != std::string::npos && open != std::string::npos && close > open)
+             {
+               std::string includePath = (folder / line.substr(open + 1, close - open - 1)).string();
+       
+               std::vector&ltstd::string> includeDependencies;
+               ss &lt&lt PreprocessShader(includePath, includeDependencies, depth + 1) &lt&lt '\n';
+       
+               //This file now also depends on everything the include did
+               for (const std::string& file : includeDependencies)
+               {
+                 result.files.emplace_back(file, std::filesystem::last_write_time(file, error));
+               }
+               continue;
+             }
+       
+       	     //Add line to selected string
+       	     ss &lt&lt line &lt&lt '\n';
+       	   }
+       
+           //Save in cache
+           result.source = ss.str();
+           for (const auto& file : result.files)
+           {
+             dependencies.push_back(file.first);
+           }
+       
+           std::lock_guard&ltstd::mutex> lock(sPreprocessMutex);
+           sPreprocessedSources[path] = result;
+           return result.source;
+         }
+        
+         /*********************************************************************
+          * @brief: Compiles a shader from a string
+          * 
+          * @param  source: The string the shader code is stored in
+          * @return The compiled shader's id
+         *********************************************************************/
+       	 unsigned int ComputeShader::CompileShader(std::string source)
+       	 {
+       	   //Creates id for the shader
+       	   unsigned int id = glCreateShader(GL_COMPUTE_SHADER);
+        
+       	   //Get string as a c string for opengl
+       	   const char* src = source.c_str();
+        
+       	   //Set the shader and compile it
+       	   glShaderSource(id, 1, &src, nullptr);
+       	   glCompileShader(id);
+        
+           //Status is checked in FinishShader, asking now would wait on the compile
+       	   return id;
+       	 }
+        
+         /*********************************************************************
+          * @brief: Starts creating a program from a shader string, the driver
+          *         may keep compiling and linking in the background until
+          *         FinishShader is called
+          * 
+          * @param  source: A compute shader in a string
+          * @param  shader: Gets set to the compiled shader, delete it once
+          *                 the program is done linking
+          * @return The Id of the created shader program
+         *********************************************************************/
+       	 unsigned int ComputeShader::CreateShader(std::string source, unsigned int* shader)
+       	 {
+           //Let the driver use as many compile threads as it likes
+           static bool threadsSet = false;
+           if (GLAD_GL_KHR_parallel_shader_compile && !threadsSet)
+           {
+             glMaxShaderCompilerThreadsKHR(0xFFFFFFFF);
+             threadsSet = true;
+           }
+       
+       	   //Create ids for shaders and program
+       	   unsigned int program = glCreateProgram();
+       	   *shader = CompileShader(source);
+        
+       	   //Attach shaders 
+       	   glAttachShader(program, *shader);
+       
+           //Ask the driver to keep the linked binary around for the program cache
+           glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+       	   glLinkProgram(program);
+        
+       	   return program;
+       	 }
+       
+         /*********************************************************************
+          * @brief: Finishes setting up this shader once its program is built,
+          *         checks for errors, caches the binary and reflects uniforms,
+          *         will wait on the driver if it is still compiling, a program
+          *         that failed to link is kept but never reflected
+         *********************************************************************/
+         void ComputeShader::FinishShader() const
+         {
+           //Already finished, marked ready up front so nothing below finishes it again
+           if (mReady)
+           {
+             return;
+           }
+           mReady = true;
+           bool linked = true;
+       
+           //Program was compiled from source
+           if (mPendingShader != 0)
+           {
+       #if defined(_DEBUG) || defined(_EDITORRELEASE)
+       	     //Error handling
+       	     int result;
+       	     glGetShaderiv(mPendingShader, GL_COMPILE_STATUS, &result);
+       	     if (result == GL_FALSE)
+       	     {
+       	       //Get length of message
+       	       int length;
+       	       glGetShaderiv(mPendingShader, GL_INFO_LOG_LENGTH, &length);
+        
+       	       //Allocate memory for message
+       	       char* message = (char*)_malloca(length * sizeof(char));
+        
+       	       glGetShaderInfoLog(mPendingShader, length, &length, message);
+       	       KL_CRITICAL("Failed to compile compute shader! \n {}", message)
+       	     }
+       
+       	     //Check for successful linkage
+       	     GLint isLinked = 0;
+       	     glGetProgramiv(mComputeShaderID, GL_LINK_STATUS, &isLinked);
+       	     if (isLinked == GL_FALSE)
+       	     {
+       	       GLint maxLength = 0;
+       	       glGetProgramiv(mComputeShaderID, GL_INFO_LOG_LENGTH, &maxLength);
+        
+       	       //The maxLength includes the NULL character
+       	       std::vector&ltGLchar> infoLog(maxLength);
+       	       glGetProgramInfoLog(mComputeShaderID, maxLength, &maxLength, &infoLog[0]);
+        
+       	       KL_CRITICAL("Failed to link compute shader! \n {}", infoLog.data())
+        
+       	       //The program is useless now, it gets deleted with this shader
+               linked = false;
+       	     }
+             else
+             {
+       	       KL_INFO("Successfully linked compute shader")
+             }
+       #endif
+       
+       	     //Can now delete shaders on our side (OpenGL has them)
+       	     glDeleteShader(mPendingShader);
+             mPendingShader = 0;
+       
+       	     //Finish attaching shaders and cache it for next time
+             if (linked)
+             {
+       	       glValidateProgram(mComputeShaderID);
+               SaveProgramBinary();
+             }
+           }
+       
+           //Find every uniform this shader has so they can be set by handle
+           if (linked)
+           {
+             ReflectUniforms();
+       
+             //Find the layout of this shader's uniform block if it has one
+             ReflectUniformBlock();
+           }
+       
+           std::chrono::duration&ltfloat, std::milli> time = std::chrono::steady_clock::now() - mLoadStart;
+           KL_INFO("Compute shader {} ready in {}ms", mFilePath, time.count())
+         }
+
+         /*********************************************************************
+          * @brief: Gets the key a cached program binary must match, changes 
+          *         whenever the source or the driver does
+          * 
+          * @param  source: The compute shader source code
+          * @return Hash of the source and the driver's vendor/renderer/version
+         *********************************************************************/
+         size_t ComputeShader::GetProgramCacheKey(const std::string& source)
+         {
+           //Binaries are only valid for the driver that made them
+           std::string key = source;
+           key += reinterpret_cast&ltconst char*>(glGetString(GL_VENDOR));
+           key += reinterpret_cast&ltconst char*>(glGetString(GL_RENDERER));
+           key += reinterpret_cast&ltconst char*>(glGetString(GL_VERSION));
+       
+           return std::hash&ltstd::string>{}(key);
+         }
+       
+         /*********************************************************************
+          * @brief: Gets the path this shader's program binary is cached at
+          * 
+          * @return Path of the cache file for this shader
+         *********************************************************************/
+         std::string ComputeShader::GetProgramCachePath() const
+         {
+           return sProgramCacheFolder + std::to_string(std::hash&ltstd::string>{}(mFilePath)) + ".bin";
+         }
+       
+         /*********************************************************************
+          * @brief: Creates a program from this shader's cached binary, fails
+          *         if there is no cache, it is stale, or the driver rejects it
+          * 
+          * @return The Id of the created shader program, 0 if it failed
+         *********************************************************************/
+         unsigned int ComputeShader::LoadProgramBinary()
+         {
+           //Driver has to support at least one binary format
+           GLint formatCount = 0;
+           glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formatCount);
+           if (formatCount == 0)
+           {
+             return 0;
+           }
+       
+           //Open cache file at the end, so its size is known before trusting the header
+           std::ifstream file(GetProgramCachePath(), std::ios::binary | std::ios::ate);
+           if (!file.is_open())
+           {
+             return 0;
+           }
+           std::streamoff fileSize = file.tellg();
+           file.seekg(0);
+       
+           //Make sure it was made from this source on this driver
+           ProgramCacheHeader header{};
+           file.read(reinterpret_cast&ltchar*>(&header), sizeof(header));
+           if (!file || header.magic != sProgramCacheMagic || header.key != mProgramCacheKey)
+           {
+             KL_INFO("Cached compute shader binary for {} is stale, recompiling", mFilePath)
+             return 0;
+           }
+       
+           //Truncated or corrupt files can claim any length, so check it fits before allocating
+           if (header.length &lt= 0 || header.length > fileSize - static_cast&ltstd::streamoff>(sizeof(header)))
+           {
+             KL_WARN("Cached compute shader binary for {} is corrupt, recompiling", mFilePath);
+             return 0;
+           }
+       
+           //Read binary
+           std::vector&ltchar> binary(header.length);
+           file.read(binary.data(), header.length);
+           if (!file)
+           {
+             return 0;
+           }
+       
+           //Hand it to the driver
+           unsigned int program = glCreateProgram();
+           glProgramBinary(program, header.format, binary.data(), header.length);
+       
+           //Driver can still reject it, so fall back to source if it did
+           GLint isLinked = 0;
+           glGetProgramiv(program, GL_LINK_STATUS, &isLinked);
+           if (isLinked == GL_FALSE)
+           {
+             KL_WARN("Driver rejected cached compute shader binary for {}, recompiling", mFilePath);
+             glDeleteProgram(program);
+             return 0;
+           }
+       
+           return program;
+         }
+       
+         /*********************************************************************
+          * @brief: Writes this shader's linked program binary to the cache so
+          *         the next launch can skip compiling it
+         *********************************************************************/
+         void ComputeShader::SaveProgramBinary() const
+         {
+           //Nothing to save if the program failed
+           if (mComputeShaderID == 0)
+           {
+             return;
+           }
+       
+           //Get binary from the driver
+           GLint length = 0;
+           glGetProgramiv(mComputeShaderID, GL_PROGRAM_BINARY_LENGTH, &length);
+           if (length == 0)
+           {
+             return;
+           }
+       
+           ProgramCacheHeader header{ sProgramCacheMagic, mProgramCacheKey, 0, 0 };
+           std::vector&ltchar> binary(length);
+           glGetProgramBinary(mComputeShaderID, length, &header.length, &header.format, binary.data());
+       
+           //Cache is only a speedup, so failing to make its folder just skips saving
+           std::error_code error;
+           std::filesystem::create_directories(sProgramCacheFolder, error);
+           if (error)
+           {
+             KL_WARN("Could not create shader cache folder {}: {}", sProgramCacheFolder, error.message());
+             return;
+           }
+       
+           //Write header then binary
+           std::ofstream file(GetProgramCachePath(), std::ios::binary | std::ios::trunc);
+           file.write(reinterpret_cast&ltconst char*>(&header), sizeof(header));
+           file.write(binary.data(), header.length);
+         }
+        
+         /*********************************************************************
+          * @brief: Finds every active uniform in this shader's program and 
+          *         gives each one a slot, so uniforms can be set by handle 
+          *         without any name lookups
+         *********************************************************************/
+         void ComputeShader::ReflectUniforms() const
+         {
+           //Forget uniforms from any older program
+           mUniformHandles.clear();
+           mUniformSlots.clear();
+       
+           //Get number of uniforms
+           GLint uniformCount = 0;
+           glGetProgramInterfaceiv(mComputeShaderID, GL_UNIFORM, GL_ACTIVE_RESOURCES, &uniformCount);
+       
+           const GLenum properties[] = { GL_BLOCK_INDEX, GL_LOCATION, GL_ARRAY_SIZE, GL_TYPE };
+           int shadowSize = 0;
+           for (GLint i = 0; i &lt uniformCount; ++i)
+           {
+             GLint values[4];
+             glGetProgramResourceiv(mComputeShaderID, GL_UNIFORM, i, 4, properties, 4, nullptr, values);
+       
+             //Block members are set through SetBlockUniform instead
+             if (values[0] != -1)
+             {
+               continue;
+             }
+       
+             //Arrays are reported as name[0], store them by their plain name
+             char name[256];
+             glGetProgramResourceName(mComputeShaderID, GL_UNIFORM, i, sizeof(name), nullptr, name);
+             std::string uniformName = name;
+             size_t bracket = uniformName.find('[');
+             if (bracket != std::string::npos)
+             {
+               uniformName.erase(bracket);
+             }
+       
+             //Give uniform a slot, its shadow lives in the arena after the last slot's
+             UniformSlot slot;
+             slot.location = values[1];
+             slot.offset = shadowSize;
+             slot.type = values[3];
+             slot.components = GetTypeComponents(values[3]);
+             slot.size = values[2] * slot.components;
+             slot.set = false;
+             shadowSize += slot.size;
+       
+             mUniformHandles[uniformName] = static_cast&ltint>(mUniformSlots.size());
+             mUniformSlots.push_back(slot);
+           }
+       
+           //Make one block of memory for every uniform's shadow, setting by handle never resizes it
+           mUniformShadow.assign(shadowSize, 0.0f);
+         }
+       
+         /*********************************************************************
+          * @brief: Checks if passed uniform needs to be sent to gpu based on 
+          *         its saved old value in the shadow arena, updates the saved
+          *         value as well if data is different
+          * 
+          * @param  handle: Handle of the uniform
+          * @param  input: Array of values that is the uniform data
+          * @param  count: length of input
+          * @return True if this uniform needs to be resent to the gpu
+         *********************************************************************/
+         bool ComputeShader::checkUniformSlot(int handle, const float* input, int count) const
+         {
+           //Cpu backend just keeps the values for its kernel to read, nothing goes to the gpu
+           if (mCpuKernel)
+           {
+             if (handle >= 0 && handle &lt static_cast&ltint>(mCpuUniforms.size()))
+             {
+               mCpuUniforms[handle].assign(input, input + count);
+             }
+             return false;
+           }
+       
+           //Uniform doesn't exist
+           if (handle &lt 0 || handle >= static_cast&ltint>(mUniformSlots.size()))
+           {
+             return false;
+           }
+       
+           //Never write past the reflected size
+           UniformSlot& slot = mUniformSlots[handle];
+           if (count > slot.size)
+           {
+             KL_WARN("Warning: uniform set with more values than it holds!");
+             count = slot.size;
+           }
+       
+           //Values match and have been sent before
+           float* shadow = mUniformShadow.data() + slot.offset;
+           size_t bytes = sizeof(float) * count;
+           if (slot.set && std::memcmp(shadow, input, bytes) == 0)
+           {
+             return false;
+           }
+       
+           //Save new values
+           std::memcpy(shadow, input, bytes);
+           slot.set = true;
+           return true;
+         }
+       
+         /*********************************************************************
+          * @brief: Copies every uniform's current value, so a recorded 
+          *         dispatch can run with the values it was recorded with
+          * 
+          * @return Copy of the uniform shadow, block data and cpu uniforms
+         *********************************************************************/
+         ComputeShader::UniformSnapshot ComputeShader::SaveUniforms() const
+         {
+           //Uniforms are only known once the shader is built
+           Wait();
+           return UniformSnapshot{ mUniformShadow, mUniformBlockData, mCpuUniforms };
+         }
+       
+         /*********************************************************************
+          * @brief: Puts uniforms back to a snapshot from SaveUniforms, only 
+          *         resending the ones that changed since, doesn't need the 
+          *         program bound
+          * 
+          * @param  snapshot: Uniform values to go back to
+         *********************************************************************/
+         void ComputeShader::RestoreUniforms(const UniformSnapshot& snapshot) const
+         {
+           //Cpu kernels read their uniforms straight from the shader
+           if (mCpuKernel)
+           {
+             mCpuUniforms = snapshot.cpu;
+             return;
+           }
+       
+           //Shader was relinked since (hot reload), the old values don't line up anymore
+           if (snapshot.shadow.size() != mUniformShadow.size() || snapshot.block.size() != mUniformBlockData.size())
+           {
+             KL_WARN("Uniforms of {} changed layout after being saved, not restoring them", mFilePath);
+             return;
+           }
+       
+           for (UniformSlot& slot : mUniformSlots)
+           {
+             //Nothing changed since the snapshot
+             const float* saved = snapshot.shadow.data() + slot.offset;
+             float* shadow = mUniformShadow.data() + slot.offset;
+             if (std::memcmp(shadow, saved, sizeof(float) * slot.size) == 0)
+             {
+               continue;
+             }
+             std::memcpy(shadow, saved, sizeof(float) * slot.size);
+             slot.set = true;
+       
+             //Program uniforms so whatever is bound is left alone
+             GLsizei count = slot.size / slot.components;
+             switch (slot.type)
+             {
+               case GL_FLOAT_VEC2: glProgramUniform2fv(mComputeShaderID, slot.location, count, shadow); break;
+               case GL_FLOAT_VEC3: glProgramUniform3fv(mComputeShaderID, slot.location, count, shadow); break;
+               case GL_FLOAT_VEC4: glProgramUniform4fv(mComputeShaderID, slot.location, count, shadow); break;
+               case GL_FLOAT_MAT2: glProgramUniformMatrix2fv(mComputeShaderID, slot.location, count, GL_FALSE, shadow); break;
+               case GL_FLOAT_MAT3: glProgramUniformMatrix3fv(mComputeShaderID, slot.location, count, GL_FALSE, shadow); break;
+               case GL_FLOAT_MAT4: glProgramUniformMatrix4fv(mComputeShaderID, slot.location, count, GL_FALSE, shadow); break;
+               default:            glProgramUniform1fv(mComputeShaderID, slot.location, count, shadow); break;
+             }
+           }
+       
+           //Block goes up with the next dispatch
+           if (mUniformBlockData != snapshot.block)
+           {
+             mUniformBlockData = snapshot.block;
+             mDirtyBegin = 0;
+             mDirtyEnd = static_cast&ltint>(mUniformBlockData.size());
+           }
+         }
+       
+         /*********************************************************************
+          * @brief: Gets how many floats a uniform of passed type takes up
+          * 
+          * @param  type: Opengl type of the uniform
+          * @return Number of components in the type
+         *********************************************************************/
+         int ComputeShader::GetTypeComponents(unsigned int type)
+         {
+           switch (type)
+           {
+             case GL_FLOAT_VEC2: return 2;
+             case GL_FLOAT_VEC3: return 3;
+             case GL_FLOAT_VEC4: return 4;
+             case GL_FLOAT_MAT2: return 4;
+             case GL_FLOAT_MAT3: return 9;
+             case GL_FLOAT_MAT4: return 16;
+             default:            return 1;
+           }
+         }
+
+         /*********************************************************************
+          * @brief: Loop run by the watcher thread, checks this shader's files
+          *         for changes and preprocesses the new source off the main
+          *         thread when they do
+         *********************************************************************/
+         void ComputeShader::WatchFiles()
+         {
+           std::vector&ltstd::filesystem::file_time_type> times = GetDependencyTimes();
+           while (mWatching)
+           {
+             std::this_thread::sleep_for(std::chrono::milliseconds(100));
+       
+             //Nothing changed
+             std::vector&ltstd::filesystem::file_time_type> newTimes = GetDependencyTimes();
+             if (newTimes == times)
+             {
+               continue;
+             }
+       
+             //Read new source (includes may have changed too, so watch whatever it uses now)
+             auto detected = std::chrono::steady_clock::now();
+             std::string source = ParseShader();
+             times = GetDependencyTimes();
+       
+             //Hand it to the main thread
+             {
+               std::lock_guard&ltstd::mutex> lock(mReloadMutex);
+               mReloadSource = std::move(source);
+               mReloadDetected = detected;
+             }
+             mReloadPending = true;
+           }
+         }
+       
+         /*********************************************************************
+          * @brief: Gets the last write times of every file this shader's 
+          *         source came from
+          * 
+          * @return Write time of each dependency, in dependency order
+         *********************************************************************/
+         std::vector&ltstd::filesystem::file_time_type> ComputeShader::GetDependencyTimes() const
+         {
+           std::lock_guard&ltstd::mutex> lock(mReloadMutex);
+       
+           std::vector&ltstd::filesystem::file_time_type> times;
+           for (const std::string& file : mDependencies)
+           {
+             std::error_code error;
+             times.push_back(std::filesystem::last_write_time(file, error));
+           }
+       
+           return times;
+         }
+
+         /*********************************************************************
+          * @brief: Finds the layout of this shader's first uniform block 
+          *         (std140 offsets of every member) and makes the buffer and
+          *         cpu side copy it gets sent from
+         *********************************************************************/
+         void ComputeShader::ReflectUniformBlock() const
+         {
+           //Forget block from any older program
+           mBlockUniforms.clear();
+           ForgetBuffer(mUniformBlockBuffer);
+           glDeleteBuffers(1, &mUniformBlockBuffer);
+           mUniformBlockBuffer = 0;
+           mDirtyBegin = INT_MAX;
+           mDirtyEnd = 0;
+       
+           //Shader might not use a block
+           GLint blockCount = 0;
+           glGetProgramiv(mComputeShaderID, GL_ACTIVE_UNIFORM_BLOCKS, &blockCount);
+           if (blockCount == 0)
+           {
+             return;
+           }
+       
+           //Get size and binding of the block
+           GLint blockSize = 0;
+           glGetActiveUniformBlockiv(mComputeShaderID, 0, GL_UNIFORM_BLOCK_DATA_SIZE, &blockSize);
+           glGetActiveUniformBlockiv(mComputeShaderID, 0, GL_UNIFORM_BLOCK_BINDING, &mUniformBlockBinding);
+       
+           //Get every member of the block
+           GLint memberCount = 0;
+           glGetActiveUniformBlockiv(mComputeShaderID, 0, GL_UNIFORM_BLOCK_ACTIVE_UNIFORMS, &memberCount);
+           std::vector&ltGLint> members(memberCount);
+           glGetActiveUniformBlockiv(mComputeShaderID, 0, GL_UNIFORM_BLOCK_ACTIVE_UNIFORM_INDICES, members.data());
+       
+           //Save where each member lives in the block
+           for (GLint member : members)
+           {
+             GLuint index = static_cast&ltGLuint>(member);
+             GLint offset = 0;
+             GLint stride = 0;
+             glGetActiveUniformsiv(mComputeShaderID, 1, &index, GL_UNIFORM_OFFSET, &offset);
+             glGetActiveUniformsiv(mComputeShaderID, 1, &index, GL_UNIFORM_ARRAY_STRIDE, &stride);
+       
+             //Arrays are reported as name[0], store them by their plain name
+             char name[256];
+             glGetActiveUniformName(mComputeShaderID, index, sizeof(name), nullptr, name);
+             std::string memberName = name;
+             size_t bracket = memberName.find('[');
+             if (bracket != std::string::npos)
+             {
+               memberName.erase(bracket);
+             }
+       
+             mBlockUniforms[memberName] = BlockUniform{ offset, stride };
+           }
+       
+           //Make the cpu copy and the buffer it gets sent to
+           mUniformBlockData.assign(blockSize, 0);
+           glGenBuffers(1, &mUniformBlockBuffer);
+           CachedBindBuffer(GL_UNIFORM_BUFFER, mUniformBlockBuffer);
+           glBufferData(GL_UNIFORM_BUFFER, blockSize, mUniformBlockData.data(), GL_DYNAMIC_DRAW);
+         }
+       
+         /*********************************************************************
+          * @brief: Writes a block member into the cpu copy of the uniform
+          *         block, only marking the bytes that actually changed dirty
+          * 
+          * @param  uniform: Block member to write
+          * @param  input: Values to write
+          * @param  count: Number of elements in input
+          * @param  components: Number of floats in each element
+         *********************************************************************/
+         void ComputeShader::writeUniformBlock(BlockUniform uniform, const float* input, int count, int components) const
+         {
+           //Member does not exist
+           if (uniform.offset &lt 0)
+           {
+             return;
+           }
+       
+           //Arrays are padded out to their stride in std140, single values are not
+           int elementBytes = sizeof(float) * components;
+           int stride = uniform.arrayStride != 0 ? uniform.arrayStride : elementBytes;
+           for (int i = 0; i &lt count; ++i)
+           {
+             int offset = uniform.offset + i * stride;
+       
+             //Make sure the write fits in the block
+             if (offset + elementBytes > static_cast&ltint>(mUniformBlockData.size()))
+             {
+               KL_WARN("Warning: block uniform write past the end of the block!");
+               return;
+             }
+       
+             //Only copy and mark dirty if different
+             unsigned char* destination = mUniformBlockData.data() + offset;
+             if (std::memcmp(destination, input + i * components, elementBytes) != 0)
+             {
+               std::memcpy(destination, input + i * components, elementBytes);
+               mDirtyBegin = std::min(mDirtyBegin, offset);
+               mDirtyEnd = std::max(mDirtyEnd, offset + elementBytes);
+             }
+           }
+         }
+       
+         /*********************************************************************
+          * @brief: Sends the changed part of the cpu copy of the uniform block
+          *         to the gpu in a single call and binds the block
+         *********************************************************************/
+         void ComputeShader::UploadUniformBlock() const
+         {
+           //Shader has no block
+           if (mUniformBlockBuffer == 0)
+           {
+             return;
+           }
+       
+           //Send only the dirty range
+           if (mDirtyBegin &lt mDirtyEnd)
+           {
+             CachedBindBuffer(GL_UNIFORM_BUFFER, mUniformBlockBuffer);
+             glBufferSubData(GL_UNIFORM_BUFFER, mDirtyBegin, mDirtyEnd - mDirtyBegin, mUniformBlockData.data() + mDirtyBegin);
+       
+             //Nothing dirty anymore
+             mDirtyBegin = INT_MAX;
+             mDirtyEnd = 0;
+           }
+       
+           CachedBindBufferBase(GL_UNIFORM_BUFFER, mUniformBlockBinding, mUniformBlockBuffer);
+         }
+
+         /*********************************************************************
+          * @brief: Waits for a fence to signal then deletes it, time spent 
+          *         waiting is added to the stall time
+          * 
+          * @param  fence: Fence to wait on, set to nullptr after
+         *********************************************************************/
+         void ComputeShader::WaitForFence(GLsync* fence) const
+         {
+           //Nothing to wait on
+           if (*fence == nullptr)
+           {
+             return;
+           }
+       
+           //Wait in 1ms steps, flushing the first time so the fence is sure to signal
+           auto start = std::chrono::steady_clock::now();
+           GLbitfield flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+           while (glClientWaitSync(*fence, flags, 1000000) == GL_TIMEOUT_EXPIRED)
+           {
+             flags = 0;
+           }
+           mStallTime += std::chrono::duration&ltfloat, std::milli>(std::chrono::steady_clock::now() - start).count();
+       
+           glDeleteSync(*fence);
+           *fence = nullptr;
+         }
+
+         /*********************************************************************
+          * @brief: Runs this shader's cpu kernel over every work group, split
+          *         into chunks across the cpu thread pool
+          * 
+          * @param  groupCounts: Number of work groups in x, y and z
+         *********************************************************************/
+         void ComputeShader::RunCpuKernel(glm::uvec3 groupCounts) const
+         {
+           static CpuThreadPool pool;
+           auto start = std::chrono::steady_clock::now();
+       
+           //A few chunks per thread keeps them busy without fighting over every group
+           unsigned int groupCount = groupCounts.x * groupCounts.y * groupCounts.z;
+           if (groupCount == 0)
+           {
+             return;
+           }
+           unsigned int chunkSize = std::max(1u, groupCount / (pool.Size() * 4));
+           unsigned int chunkCount = (groupCount + chunkSize - 1) / chunkSize;
+       
+           std::function&ltvoid(unsigned int)> job = [&](unsigned int chunk)
+           {
+             unsigned int end = std::min(groupCount, (chunk + 1) * chunkSize);
+             for (unsigned int group = chunk * chunkSize; group &lt end; ++group)
+             {
+               CpuWorkGroup workGroup;
+               workGroup.groupID = glm::uvec3(group % groupCounts.x, 
+                                              (group / groupCounts.x) % groupCounts.y, 
+                                              group / (groupCounts.x * groupCounts.y));
+               workGroup.localSize = mCpuLocalSize;
+               workGroup.shader = this;
+               mCpuKernel(workGroup);
+             }
+           };
+           pool.Run(chunkCount, job);
+       
+           //Save invocations per millisecond to compare against the gpu
+           std::chrono::duration&ltfloat, std::milli> time = std::chrono::steady_clock::now() - start;
+           float invocations = static_cast&ltfloat>(groupCount) * mCpuLocalSize.x * mCpuLocalSize.y * mCpuLocalSize.z;
+           mCpuThroughput = invocations / std::max(time.count(), 0.001f);
+         }
+       
+         /*********************************************************************
+          * @brief: Gets how fast the last cpu dispatch ran, compare with gpu
+          *         timing scopes to see what the cpu fallback costs
+          * 
+          * @return Invocations per millisecond of the last cpu dispatch
+         *********************************************************************/
+         float ComputeShader::GetCpuThroughput() const
+         {
+           return mCpuThroughput;
+         }
+       
+         //--------------------------------------------------------------------------------------
+         //Cpu work group functions--------------------------------------------------------------
+         //--------------------------------------------------------------------------------------
+         /*********************************************************************
+          * @brief: Gets the buffer bound at passed index, the same index the 
+          *         gpu shader uses for its storage buffer binding
+          * 
+          * @param  index: Binding index of the buffer
+          * @return Pointer to the buffer's floats, nullptr if nothing bound
+          *         or the bound buffer was deleted
+         *********************************************************************/
+         float* CpuWorkGroup::Buffer(int index) const
+         {
+           auto binding = shader->mCpuBindings.find(index);
+           if (binding == shader->mCpuBindings.end())
+           {
+             return nullptr;
+           }
+       
+           //Only look up, work groups run on many threads at once so nothing can be added here
+           auto buffer = shader->mCpuBuffers.find(binding->second);
+           if (buffer == shader->mCpuBuffers.end())
+           {
+             return nullptr;
+           }
+       
+           return reinterpret_cast&ltfloat*>(buffer->second.data());
+         }
+       
+         /*********************************************************************
+          * @brief: Gets the values last set for a uniform
+          * 
+          * @param  handle: Handle of the uniform (from GetUniformHandle)
+          * @return Pointer to the uniform's floats, nullptr for a bad handle
+         *********************************************************************/
+         const float* CpuWorkGroup::Uniform(int handle) const
+         {
+           if (handle &lt 0 || static_cast&ltsize_t>(handle) >= shader->mCpuUniforms.size())
+           {
+             return nullptr;
+           }
+       
+           return shader->mCpuUniforms[handle].data();
+         }
+       
+         //--------------------------------------------------------------------------------------
+         //Dispatch recorder functions-----------------------------------------------------------
+         //--------------------------------------------------------------------------------------
+         /*********************************************************************
+          * @brief: Records a dispatch to run on Submit, the shader's uniforms
+          *         are saved with it so setting them again before Submit 
+          *         only changes later recordings
+          * 
+          * @param  shader: Shader to dispatch
+          * @param  groupCounts: Number of work groups in x, y and z
+          * @param  reads: Barrier bits for how this dispatch uses earlier 
+          *                dispatches' writes (GL_SHADER_STORAGE_BARRIER_BIT...)
+          * @param  writes: Barrier bits later readers of this dispatch's 
+          *                 output will need
+         *********************************************************************/
+         void ComputeDispatchRecorder::Record(const ComputeShader& shader, glm::uvec3 groupCounts, GLbitfield reads, GLbitfield writes)
+         {
+           mDispatches.push_back(RecordedDispatch{ &shader, groupCounts, 0, 0, reads, writes, shader.SaveUniforms() });
+         }
+       
+         /*********************************************************************
+          * @brief: Records an indirect dispatch to run on Submit, the group 
+          *         counts buffer is treated as a command read so a barrier is
+          *         only added if an earlier dispatch wrote commands, uniforms
+          *         are saved like Record
+          * 
+          * @param  shader: Shader to dispatch
+          * @param  bufferID: Id of buffer holding the x, y, z group counts
+          * @param  offset: Byte offset of the counts in the buffer
+          * @param  reads: Barrier bits for how this dispatch uses earlier 
+          *                dispatches' writes
+          * @param  writes: Barrier bits later readers of this dispatch's 
+          *                 output will need
+         *********************************************************************/
+         void ComputeDispatchRecorder::RecordIndirect(const ComputeShader& shader, unsigned int bufferID, intptr_t offset, 
+                                                      GLbitfield reads, GLbitfield writes)
+         {
+           mDispatches.push_back(RecordedDispatch{ &shader, glm::uvec3(0, 0, 0), bufferID, offset, 
+                                                   reads | GL_COMMAND_BARRIER_BIT, writes, shader.SaveUniforms() });
+         }
+       
+         /*********************************************************************
+          * @brief: Runs every recorded dispatch in order, only adding the 
+          *         barrier bits a dispatch reads that some earlier dispatch 
+          *         wrote and has not been barriered yet, then clears the 
+          *         recording
+          * 
+          * @param  finalBarrier: Barrier bits the work after this needs from
+          *                       the recorded dispatches, 0 for none
+         *********************************************************************/
+         void ComputeDispatchRecorder::Submit(GLbitfield finalBarrier)
+         {
+           //Anything could have been bound since the last batch
+           ComputeShader::InvalidateStateCache();
+       
+           //Uniforms set after the last recording are put back once the batch is done
+           std::vector&ltstd::pair&ltconst ComputeShader*, ComputeShader::UniformSnapshot>> latest;
+           for (const RecordedDispatch& dispatch : mDispatches)
+           {
+             auto saved = std::find_if(latest.begin(), latest.end(), [&](const auto& entry) { return entry.first == dispatch.shader; });
+             if (saved == latest.end())
+             {
+               latest.emplace_back(dispatch.shader, dispatch.shader->SaveUniforms());
+             }
+           }
+       
+           GLbitfield pending = 0;
+           const ComputeShader* bound = nullptr;
+           for (const RecordedDispatch& dispatch : mDispatches)
+           {
+             //Only wait on writes this dispatch actually reads
+             GLbitfield barrier = pending & dispatch.reads;
+             if (barrier != 0)
+             {
+               glMemoryBarrier(barrier);
+               pending &= ~barrier;
+               ++mBarriersIssued;
+             }
+       
+             //Only switch programs when the shader changes
+             if (dispatch.shader != bound)
+             {
+               dispatch.shader->Bind();
+               bound = dispatch.shader;
+             }
+       
+             //Run with the uniforms this dispatch was recorded with
+             dispatch.shader->RestoreUniforms(dispatch.uniforms);
+       
+             if (dispatch.indirectBuffer != 0)
+             {
+               dispatch.shader->DispatchIndirect(dispatch.indirectBuffer, dispatch.indirectOffset, 0);
+             }
+             else
+             {
+               dispatch.shader->Dispatch(dispatch.groupCounts, 0);
+             }
+       
+             pending |= dispatch.writes;
+           }
+       
+           //One barrier for whatever comes next
+           if ((pending & finalBarrier) != 0)
+           {
+             glMemoryBarrier(pending & finalBarrier);
+             ++mBarriersIssued;
+           }
+       
+           //Without merging every dispatch would get its own full barrier
+           mBarriersNaive += static_cast&ltint>(mDispatches.size());
+       
+           //Go back to the image drawing shader
+           if (bound != nullptr)
+           {
+             bound->Unbind();
+           }
+       
+           for (const auto& [shader, uniforms] : latest)
+           {
+             shader->RestoreUniforms(uniforms);
+           }
+       
+           mDispatches.clear();
+         }
+       
+         /*********************************************************************
+          * @brief: Gets how many barriers Submit has issued, and how many one
+          *         barrier per dispatch would have, then resets both
+          * 
+          * @param  naive: Gets set to the barriers one per dispatch would be
+          * @return Number of barriers actually issued
+         *********************************************************************/
+         int ComputeDispatchRecorder::GetBarrierCounts(int* naive)
+         {
+           int issued = mBarriersIssued;
+           *naive = mBarriersNaive;
+           mBarriersIssued = 0;
+           mBarriersNaive = 0;
+           return issued;
+         }
        }
\ No newline at end of file
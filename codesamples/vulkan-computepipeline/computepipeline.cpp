@@ -11,9 +11,370 @@
        #include "Backend/Rendering/Uniform/Uniform.hpp"
        #include "Backend/Rendering/Uniform/UniformData.hpp"
        #include "Shader.hpp"
+       #include &ltglslang/Public/ShaderLang.h>
+       
+       #include &ltalgorithm>
+       #include &ltchrono>
+       #include &ltcstring>
+       #include &ltfilesystem>
+       #include &ltmutex>
+       #include &ltunordered_map>
+       #include &ltunordered_set>
+       #include &ltsstream>
+       #include &ltatomic>
+       #include &ltdeque>
+       #include &ltthread>
+       #include &ltfunctional>
+       
+       #ifdef _WIN32
+       //Keep windows.h from defining min and max macros that break std::min and std::max
+       #ifndef NOMINMAX
+       #define NOMINMAX
+       #endif
+       #include &ltwindows.h>
+       #else
+       #include &ltfcntl.h>
+       #include &ltsys/mman.h>
+       #include &ltsys/stat.h>
+       #include &ltunistd.h>
+       #endif
        
        namespace Rendering
        {
+         //Folder pipeline caches are saved to between runs
+         static const std::string sPipelineCacheFolder = "Cache/Pipelines/";
+       
+         //Pipeline cache shared by every compute pipeline made on one device
+         struct SharedPipelineCache
+         {
+           VkPipelineCache cache = VK_NULL_HANDLE; //Driver's cache object
+           std::string path;                       //File it is loaded from and saved to
+           int users = 0;                          //Pipelines using it, saved and destroyed at 0
+           bool warm = false;                      //If it started with data from disk
+         };
+         static std::unordered_map&ltVkDevice, SharedPipelineCache> sPipelineCaches;
+         static std::mutex sPipelineCacheMutex;
+       
+         //Folder compiled SPIR-V is saved to, files are named by the hash of what made them
+         static const std::string sSpirvCacheFolder = "Cache/Spirv/";
+       
+         /*********************************************************************
+          * @brief: Names the compiler SPIR-V gets cached from, the version is
+          *         asked of glslang itself so updating it never reuses old
+          *         SPIR-V, the options must match what CompileGLSLtoSPV uses
+          *
+          * @return Compiler version and options, e.g. glslang-11.1.0-vulkan1.2-O0
+         *********************************************************************/
+         static std::string GetSpirvCompilerVersion()
+         {
+           glslang::Version version = glslang::GetVersion();
+           return "glslang-" + std::to_string(version.major) + "." + std::to_string(version.minor) + "." + 
+                  std::to_string(version.patch) + version.flavor + "-vulkan1.2-O0";
+         }
+       
+         //Start of every cached SPIR-V file
+         struct SpirvCacheHeader
+         {
+           uint32_t magic;    //Always SpirvCacheMagic
+           uint32_t words;    //Number of SPIR-V words after this header
+           uint64_t key;      //Hash the file is named by, catches renamed or mixed up files
+         };
+         static const uint32_t SpirvCacheMagic = 0x53505643; //"SPVC"
+       
+         //Read only view of a whole file mapped into memory, unmapped when destroyed
+         class MappedFile
+         {
+         public:
+           MappedFile() = default;
+           MappedFile(const MappedFile&) = delete;
+           MappedFile& operator=(const MappedFile&) = delete;
+       
+           //Unmaps file
+           ~MappedFile()
+           {
+       #ifdef _WIN32
+             if (mData) UnmapViewOfFile(mData);
+             if (mMapping) CloseHandle(mMapping);
+             if (mFile != INVALID_HANDLE_VALUE) CloseHandle(mFile);
+       #else
+             if (mData) munmap(const_cast&ltchar*>(mData), mSize);
+             if (mFile != -1) close(mFile);
+       #endif
+           }
+       
+           //Maps file at passed path, returns false if it can't be opened
+           bool Open(const std::string& path)
+           {
+       #ifdef _WIN32
+             mFile = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+             if (mFile == INVALID_HANDLE_VALUE)
+             {
+               return false;
+             }
+       
+             LARGE_INTEGER size;
+             GetFileSizeEx(mFile, &size);
+             mSize = static_cast&ltsize_t>(size.QuadPart);
+             if (mSize == 0)
+             {
+               return false;
+             }
+       
+             mMapping = CreateFileMappingA(mFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+             if (mMapping == nullptr)
+             {
+               return false;
+             }
+             mData = static_cast&ltconst char*>(MapViewOfFile(mMapping, FILE_MAP_READ, 0, 0, 0));
+       #else
+             mFile = open(path.c_str(), O_RDONLY);
+             if (mFile == -1)
+             {
+               return false;
+             }
+       
+             struct stat info;
+             if (fstat(mFile, &info) != 0 || info.st_size == 0)
+             {
+               return false;
+             }
+             mSize = static_cast&ltsize_t>(info.st_size);
+       
+             void* mapped = mmap(nullptr, mSize, PROT_READ, MAP_PRIVATE, mFile, 0);
+             mData = mapped == MAP_FAILED ? nullptr : static_cast&ltconst char*>(mapped);
+       #endif
+             return mData != nullptr;
+           }
+       
+           const char* Data() const { return mData; }
+           size_t Size() const { return mSize; }
+       
+         private:
+       #ifdef _WIN32
+           HANDLE mFile = INVALID_HANDLE_VALUE;
+           HANDLE mMapping = nullptr;
+       #else
+           int mFile = -1;
+       #endif
+           const char* mData = nullptr;
+           size_t mSize = 0;
+         };
+       
+         //64 bit FNV-1a, unlike std::hash it gives the same result on every compiler so offline builds match
+         static uint64_t HashBytes(const void* data, size_t size, uint64_t hash = 14695981039346656037ull)
+         {
+           const unsigned char* bytes = static_cast&ltconst unsigned char*>(data);
+           for (size_t i = 0; i &lt size; ++i)
+           {
+             hash ^= bytes[i];
+             hash *= 1099511628211ull;
+           }
+           return hash;
+         }
+       
+         //SPIR-V opcodes, decorations and storage classes reflection reads
+         enum SpirvCode : uint32_t
+         {
+           SpirvMagic = 0x07230203,
+           OpTypeBool = 20, OpTypeInt = 21, OpTypeFloat = 22, OpTypeVector = 23, OpTypeMatrix = 24, 
+           OpTypeImage = 25, OpTypeSampler = 26, OpTypeSampledImage = 27, 
+           OpTypeArray = 28, OpTypeRuntimeArray = 29, OpTypeStruct = 30, OpTypePointer = 32, 
+           OpConstant = 43, OpVariable = 59, OpDecorate = 71, OpMemberDecorate = 72,
+           DecorationBufferBlock = 3, DecorationArrayStride = 6, DecorationMatrixStride = 7, 
+           DecorationBinding = 33, DecorationDescriptorSet = 34, DecorationOffset = 35,
+           StorageUniformConstant = 0, StorageUniform = 2, StoragePushConstant = 9, StorageStorageBuffer = 12,
+           DimBuffer = 5, ImageStorage = 2
+         };
+       
+         //Types, constants and decorations of a SPIR-V module, by id
+         struct SpirvModule
+         {
+           //A global variable
+           struct Variable
+           {
+             uint32_t type;
+             uint32_t id;
+             uint32_t storageClass;
+           };
+       
+           std::unordered_map&ltuint32_t, std::vector&ltuint32_t>> types;        //Operands of each OpType instruction, opcode first
+           std::unordered_map&ltuint32_t, uint32_t> constants;                   //Value of each 32 bit OpConstant
+           std::unordered_map&ltuint64_t, uint32_t> decorations;                 //(id, decoration) to value
+           std::unordered_map&ltuint64_t, uint32_t> memberDecorations;           //(struct, member, decoration) to value
+           std::vector&ltVariable> variables;
+       
+           //Reads passed SPIR-V, returns false if it isn't valid SPIR-V
+           bool Parse(const uint32_t* code, size_t words)
+           {
+             if (words &lt 5 || code[0] != SpirvMagic)
+             {
+               return false;
+             }
+       
+             //Every instruction starts with its word count and opcode packed in one word
+             for (size_t i = 5; i &lt words;)
+             {
+               uint32_t count = code[i] >> 16;
+               uint32_t opcode = code[i] & 0xFFFF;
+               if (count == 0 || i + count > words)
+               {
+                 return false;
+               }
+               const uint32_t* operands = code + i + 1;
+       
+               switch (opcode)
+               {
+               case OpTypeBool: case OpTypeInt: case OpTypeFloat: case OpTypeVector: case OpTypeMatrix:
+               case OpTypeImage: case OpTypeSampler: case OpTypeSampledImage: case OpTypeArray: case OpTypeRuntimeArray: case OpTypeStruct: case OpTypePointer:
+                 types[operands[0]].assign(code + i, code + i + count);
+                 types[operands[0]][0] = opcode;
+                 break;
+               case OpConstant:
+                 constants[operands[1]] = operands[2];
+                 break;
+               case OpVariable:
+                 variables.push_back({ operands[0], operands[1], operands[2] });
+                 break;
+               case OpDecorate:
+                 decorations[Key(operands[0], operands[1])] = count > 3 ? operands[2] : 1;
+                 break;
+               case OpMemberDecorate:
+                 memberDecorations[Key(operands[0], operands[1], operands[2])] = count > 4 ? operands[3] : 1;
+                 break;
+               }
+       
+               i += count;
+             }
+       
+             return true;
+           }
+       
+           //Gets a decoration's value, or fallback if the id doesn't have it
+           uint32_t Decoration(uint32_t id, uint32_t decoration, uint32_t fallback = 0) const
+           {
+             auto found = decorations.find(Key(id, decoration));
+             return found == decorations.end() ? fallback : found->second;
+           }
+       
+           //Gets a struct member's decoration's value, or fallback if it doesn't have it
+           uint32_t MemberDecoration(uint32_t id, uint32_t member, uint32_t decoration, uint32_t fallback = 0) const
+           {
+             auto found = memberDecorations.find(Key(id, member, decoration));
+             return found == memberDecorations.end() ? fallback : found->second;
+           }
+       
+           //Gets how many bytes a type takes up in a block, matrix stride comes from the member holding it
+           uint32_t Size(uint32_t id, uint32_t matrixStride = 0) const
+           {
+             auto found = types.find(id);
+             if (found == types.end())
+             {
+               return 0;
+             }
+             const std::vector&ltuint32_t>& type = found->second;
+       
+             switch (type[0])
+             {
+             case OpTypeBool:
+               return 4;
+             case OpTypeInt:
+             case OpTypeFloat:
+               return type[2] / 8;
+             case OpTypeVector:
+               return type[3] * Size(type[2]);
+             case OpTypeMatrix:
+               return type[3] * (matrixStride ? matrixStride : Size(type[2]));
+             case OpTypeArray:
+             {
+               auto length = constants.find(type[3]);
+               uint32_t count = length == constants.end() ? 0 : length->second;
+               return count * Decoration(id, DecorationArrayStride, Size(type[2]));
+             }
+             case OpTypeStruct:
+             {
+               //Members can be out of order, so the end is the furthest one
+               uint32_t size = 0;
+               for (uint32_t member = 0; member + 2 &lt type.size(); ++member)
+               {
+                 uint32_t offset = MemberDecoration(id, member, DecorationOffset);
+                 uint32_t stride = MemberDecoration(id, member, DecorationMatrixStride);
+                 size = std::max(size, offset + Size(type[2 + member], stride));
+               }
+               return size;
+             }
+             }
+       
+             //Runtime arrays have no size of their own
+             return 0;
+           }
+       
+           //Packs ids into a map key
+           static uint64_t Key(uint32_t id, uint32_t value)
+           {
+             return (static_cast&ltuint64_t>(id) &lt&lt 32) | value;
+           }
+           static uint64_t Key(uint32_t id, uint32_t member, uint32_t value)
+           {
+             return (static_cast&ltuint64_t>(id) &lt&lt 32) | (member &lt&lt 16) | value;
+           }
+         };
+       
+         //How often the hot reload thread checks the shader for changes
+         static const std::chrono::milliseconds sHotReloadInterval{ 250 };
+       
+         //Checks if a rebuilt shader can use the old pipeline layout
+         static bool IsLayoutCompatible(const ShaderReflection& a, const ShaderReflection& b)
+         {
+           if (a.pushConstantSize != b.pushConstantSize || a.bindings.size() != b.bindings.size())
+           {
+             return false;
+           }
+       
+           for (size_t i = 0; i &lt a.bindings.size(); ++i)
+           {
+             const ReflectedBinding& x = a.bindings[i];
+             const ReflectedBinding& y = b.bindings[i];
+             if (x.set != y.set || x.binding != y.binding || x.descriptorType != y.descriptorType || x.count != y.count)
+             {
+               return false;
+             }
+           }
+           return true;
+         }
+       
+         //Makes a string safe to put between quotes in json
+         static std::string EscapeJson(const std::string& text)
+         {
+           static const char* hex = "0123456789abcdef";
+           std::string escaped;
+           escaped.reserve(text.size());
+           for (char c : text)
+           {
+             unsigned char byte = static_cast&ltunsigned char>(c);
+             switch (c)
+             {
+             case '"':  escaped += "\\\""; break;
+             case '\\': escaped += "\\\\"; break;
+             case '\n': escaped += "\\n"; break;
+             case '\r': escaped += "\\r"; break;
+             case '\t': escaped += "\\t"; break;
+             default:
+               //Other control characters have no short form
+               if (byte &lt 0x20)
+               {
+                 escaped += "\\u00";
+                 escaped += hex[byte >> 4];
+                 escaped += hex[byte & 0xF];
+               }
+               else
+               {
+                 escaped += c;
+               }
+             }
+           }
+           return escaped;
+         }
+       
          /*********************************************************************
           * @brief: Creates a new Compute pipeline
           * 
@@ -27,23 +388,196 @@
        	   : mPipelineDevice(device)
            , mPath(computeFilePath)
        	 {
+           mPipelineCache = AcquirePipelineCache(device);
+       
+           //Layout needs the shader's push constants, so load it first
+           LoadShader();
        	   CreatePipelineLayout(uniforms);
        	   CreatePipeline();
        	 }
+       
+         /*********************************************************************
+          * @brief: Creates a new Compute pipeline with its descriptor set 
+          *         layouts built from what the shader declares
+          * 
+          * @param  device: Device this pipeline uses
+          * @param  computeFilePath: Path to compute shader code file
+         *********************************************************************/
+         ComputePipeline::ComputePipeline(Device& device, const std::string& computeFilePath)
+           : mPipelineDevice(device)
+           , mPath(computeFilePath)
+         {
+           mPipelineCache = AcquirePipelineCache(device);
+       
+           LoadShader();
+           CreatePipelineLayout();
+           CreatePipeline();
+         }
+       
+         /*********************************************************************
+          * @brief: Creates a compute pipeline with nothing built yet, 
+          *         BuildPipelines finishes it on worker threads
+          * 
+          * @param  device: Device this pipeline uses
+          * @param  computeFilePath: Path to compute shader code file
+          * @param  deferred: Tag picking this constructor
+         *********************************************************************/
+         ComputePipeline::ComputePipeline(Device& device, const std::string& computeFilePath, DeferredBuild)
+           : mPipelineDevice(device)
+           , mPath(computeFilePath)
+         {
+           mPipelineCache = AcquirePipelineCache(device);
+         }
+       
+         /*********************************************************************
+          * @brief: Creates many compute pipelines at once, reading, 
+          *         compiling and creating shader modules across threads then
+          *         creating the pipelines in one batch per thread
+          * 
+          * @param  device: Device the pipelines use
+          * @param  builds: Uniforms and shader path of each pipeline
+          * @param  threadCount: Threads to build on, 0 uses every core
+          * @return Finished pipelines, in the same order as builds
+         *********************************************************************/
+         std::vector&ltstd::unique_ptr&ltComputePipeline>> ComputePipeline::BuildPipelines(Device& device, 
+                                                                                        const std::vector&ltBuildInfo>& builds, 
+                                                                                        unsigned int threadCount)
+         {
+           auto start = std::chrono::steady_clock::now();
+           if (threadCount == 0)
+           {
+             threadCount = std::max(1u, std::thread::hardware_concurrency());
+           }
+           threadCount = std::min(threadCount, static_cast&ltunsigned int>(std::max&ltsize_t>(builds.size(), 1)));
+       
+           std::vector&ltstd::unique_ptr&ltComputePipeline>> pipelines;
+           for (const BuildInfo& build : builds)
+           {
+             pipelines.emplace_back(new ComputePipeline(device, build.computeFilePath, DeferredBuild{}));
+           }
+       
+           //Shader modules are the slow part (glslang), so each thread takes the next one left
+           std::atomic&ltsize_t> next{ 0 };
+           auto loadModules = [&]()
+           {
+             for (size_t i = next++; i &lt pipelines.size(); i = next++)
+             {
+               LoadShaderModule(device, pipelines[i]->mPath, &pipelines[i]->mComputeShaderModule, &pipelines[i]->mReflection);
+             }
+           };
+       
+           //Then each thread creates an even share of the pipelines in one call
+           auto createPipelines = [&](unsigned int thread)
+           {
+             size_t first = pipelines.size() * thread / threadCount;
+             size_t last = pipelines.size() * (thread + 1) / threadCount;
+             if (first == last)
+             {
+               return;
+             }
+       
+             std::vector&ltVkComputePipelineCreateInfo> createInfos;
+             std::vector&ltVkPipeline> created(last - first, VK_NULL_HANDLE);
+             for (size_t i = first; i &lt last; ++i)
+             {
+               createInfos.push_back(pipelines[i]->GetPipelineCreateInfo());
+             }
+       
+             //Pipeline caches are internally synchronized, so threads can share one
+             if (vkCreateComputePipelines(device.GetDevice(), pipelines[first]->mPipelineCache, 
+                                          static_cast&ltuint32_t>(createInfos.size()), createInfos.data(), 
+                                          nullptr, created.data()) != VK_SUCCESS)
+             {
+               NL_CRITICAL("Failed to create compute pipelines");
+             }
+       
+             for (size_t i = first; i &lt last; ++i)
+             {
+               pipelines[i]->mComputePipeline = created[i - first];
+             }
+           };
+       
+           //Run both steps on every thread, all modules have to be done before they are used
+           std::vector&ltstd::thread> workers;
+           for (unsigned int i = 1; i &lt threadCount; ++i)
+           {
+             workers.emplace_back(loadModules);
+           }
+           loadModules();
+           for (std::thread& worker : workers)
+           {
+             worker.join();
+           }
+           workers.clear();
+       
+           //Layouts set uniform bindings, so they are made here with no other threads running
+           for (size_t i = 0; i &lt pipelines.size(); ++i)
+           {
+             //No uniforms means the layout comes from the shader
+             if (builds[i].uniforms.empty())
+             {
+               pipelines[i]->CreatePipelineLayout();
+             }
+             else
+             {
+               pipelines[i]->CreatePipelineLayout(builds[i].uniforms);
+             }
+           }
+       
+           for (unsigned int i = 1; i &lt threadCount; ++i)
+           {
+             workers.emplace_back(createPipelines, i);
+           }
+           createPipelines(0);
+           for (std::thread& worker : workers)
+           {
+             worker.join();
+           }
+       
+           //Log so thread counts can be compared
+           std::chrono::duration&ltfloat, std::milli> time = std::chrono::steady_clock::now() - start;
+           NL_INFO("Built " + std::to_string(pipelines.size()) + " compute pipelines on " + std::to_string(threadCount) + 
+                   " threads in " + std::to_string(time.count()) + "ms");
+       
+           return pipelines;
+         }
         
          /*********************************************************************
           * @brief: Destroys this pipeline object
          *********************************************************************/
        	 ComputePipeline::~ComputePipeline()
        	 {
+           //Stop watching for changes, then free anything a reload left behind
+           DisableHotReload();
+           if (mPendingReload.pipeline != VK_NULL_HANDLE)
+           {
+             mRetired.push_back(mPendingReload);
+           }
+           for (const RetiredShader& retired : mRetired)
+           {
+             vkDestroyPipeline(mPipelineDevice.GetDevice(), retired.pipeline, nullptr);
+             vkDestroyShaderModule(mPipelineDevice.GetDevice(), retired.module, nullptr);
+           }
+       
        	   //Destroy shaders
        	   vkDestroyShaderModule(mPipelineDevice.GetDevice(), mComputeShaderModule, nullptr);
         
        	   //Destroy pipeline
        	   vkDestroyPipeline(mPipelineDevice.GetDevice(), mComputePipeline, nullptr);
+           for (const auto& [key, variant] : mVariants)
+           {
+             vkDestroyPipeline(mPipelineDevice.GetDevice(), variant, nullptr);
+           }
         
        	   //Destroy created layout
        	   vkDestroyPipelineLayout(mPipelineDevice.GetDevice(), mPipelineLayout, nullptr);
+           for (VkDescriptorSetLayout layout : mDescriptorSetLayouts)
+           {
+             vkDestroyDescriptorSetLayout(mPipelineDevice.GetDevice(), layout, nullptr);
+           }
+       
+           //Last pipeline on the device saves the cache for next run
+           ReleasePipelineCache(mPipelineDevice);
        	 }
 
          /*********************************************************************
@@ -56,6 +590,81 @@
        	   //Bind the pipeline    
        	   vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, mComputePipeline);
        	 }
+       
+         /*********************************************************************
+          * @brief: Binds the variant of this pipeline specialized with passed
+          *         constants to passed command buffer
+          *
+          * @param  commandBuffer: Command buffer to bind too
+          * @param  constants: Constants the variant is specialized with
+         *********************************************************************/
+         void ComputePipeline::Bind(VkCommandBuffer commandBuffer, const SpecializationConstants& constants)
+         {
+           vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, GetVariant(constants));
+         }
+       
+         /*********************************************************************
+          * @brief: Sets the shader's push constant block for the next 
+          *         dispatches, PushConstants&ltT> checks the struct's size
+          *         at compile time then calls this
+          *
+          * @param  commandBuffer: Command buffer to record into
+          * @param  data: Values of the block
+          * @param  size: Size of data in bytes
+         *********************************************************************/
+         void ComputePipeline::PushConstants(VkCommandBuffer commandBuffer, const void* data, uint32_t size)
+         {
+           //Pushing past the reflected range is invalid, so catch mismatched structs here
+           if (size > mReflection.pushConstantSize)
+           {
+             NL_ERROR("Push constants for " + mPath + " are " + std::to_string(size) + " bytes but the shader's block is " + 
+                      std::to_string(mReflection.pushConstantSize));
+             return;
+           }
+       
+           vkCmdPushConstants(commandBuffer, mPipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, size, data);
+         }
+       
+         /*********************************************************************
+          * @brief: Gets the variant of this pipeline specialized with passed
+          *         constants, creating it the first time those constants are
+          *         used, every variant shares this pipeline's shader module
+          *
+          * @param  constants: Constants to specialize the shader with
+          * @return Pipeline specialized with the constants
+         *********************************************************************/
+         VkPipeline ComputePipeline::GetVariant(const SpecializationConstants& constants)
+         {
+           //Locked before reading anything, a hot reload swaps the module and pipeline under this too
+           std::lock_guard&ltstd::mutex> lock(mVariantMutex);
+       
+           //No constants is just the normal pipeline
+           if (constants.Empty())
+           {
+             return mComputePipeline;
+           }
+       
+           uint64_t key = constants.GetKey();
+           auto found = mVariants.find(key);
+           if (found != mVariants.end())
+           {
+             return found->second;
+           }
+       
+           //Driver folds the constants in, so branches on them and fixed local sizes cost nothing at runtime
+           VkSpecializationInfo specialization = constants.GetInfo();
+           VkComputePipelineCreateInfo pipelineCreateInfo = GetPipelineCreateInfo(&specialization);
+       
+           VkPipeline variant = VK_NULL_HANDLE;
+           if (vkCreateComputePipelines(mPipelineDevice.GetDevice(), mPipelineCache, 1, &pipelineCreateInfo, nullptr, &variant) 
+                != VK_SUCCESS)
+           {
+             NL_CRITICAL("Failed to create specialized compute pipeline for " + mPath);
+           }
+       
+           mVariants[key] = variant;
+           return variant;
+         }
         
           /*********************************************************************
            * @brief: Reads file at passed file path into a vector of chars,
@@ -100,6 +709,20 @@
           * @param  shaderModule: Gets set to created shader module
          *********************************************************************/
          void ComputePipeline::CreateShaderModule(Device& device, const std::vector&ltuint32_t>& code, VkShaderModule* shaderModule)
+         {
+           CreateShaderModule(device, code.data(), code.size(), shaderModule);
+         }
+
+         /*********************************************************************
+          * @brief:  Creates a shader module object with passed code and sets
+          *          passed "shaderModule" to it, takes a pointer so code can
+          *          come straight from a mapped file
+          *
+          * @param  code: Code to create shader with
+          * @param  words: Number of 32 bit words in code
+          * @param  shaderModule: Gets set to created shader module
+         *********************************************************************/
+         void ComputePipeline::CreateShaderModule(Device& device, const uint32_t* code, size_t words, VkShaderModule* shaderModule)
          {
            //Struct to hold information on how to create this shader module
            VkShaderModuleCreateInfo createInfo{};
@@ -108,10 +731,10 @@
            createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
 
            //Set the size of the passed code
-           createInfo.codeSize = code.size() * sizeof(uint32_t);
+           createInfo.codeSize = words * sizeof(uint32_t);
 
-           //Set pointer to code (cast from array of chars to a int32 pointer)
-           createInfo.pCode = reinterpret_cast&ltconst uint32_t*>(code.data());
+           //Set pointer to code
+           createInfo.pCode = code;
 
            //Create the shader module
            if (vkCreateShaderModule(device.GetDevice(), &createInfo, nullptr, shaderModule) != VK_SUCCESS)
@@ -141,10 +764,45 @@
        	     uniforms[i]->SetBinding(i);
        	     uniformsDescriptorSetLayouts.push_back(uniforms[i]->GetDescriptorLayout()->GetDescriptorSetLayout());
        	   }
+       
+           //Each uniform is its own set, the shader's bindings have to be in it with the same type
+           for (const ReflectedBinding& binding : mReflection.bindings)
+           {
+             std::string name = "set " + std::to_string(binding.set) + " binding " + std::to_string(binding.binding);
+             if (binding.set >= uniforms.size())
+             {
+               NL_ERROR("Compute shader " + mPath + " uses set " + std::to_string(binding.set) + " but only " + 
+                        std::to_string(uniforms.size()) + " uniforms were given");
+               continue;
+             }
+       
+             const std::vector&ltVkDescriptorSetLayoutBinding>& declared = uniforms[binding.set]->GetDescriptorLayout()->GetBindings();
+             auto match = std::find_if(declared.begin(), declared.end(), 
+                                       [&](const VkDescriptorSetLayoutBinding& layoutBinding) 
+                                       { return layoutBinding.binding == binding.binding; });
+             if (match == declared.end())
+             {
+               NL_ERROR("Compute shader " + mPath + " uses " + name + " but its uniform has no such binding");
+             }
+             else if (match->descriptorType != binding.descriptorType)
+             {
+               NL_ERROR("Compute shader " + mPath + " uses " + name + " as descriptor type " + 
+                        std::to_string(binding.descriptorType) + " but its uniform is type " + 
+                        std::to_string(match->descriptorType));
+             }
+           }
         
        	   //Set how many layouts are being provided and provide the layouts themselves
        	   pipelineLayoutCreateInfo.setLayoutCount = static_cast&ltuint32_t>(uniformsDescriptorSetLayouts.size());
        	   pipelineLayoutCreateInfo.pSetLayouts = uniformsDescriptorSetLayouts.data();
+       
+           //Give the shader's push constant block (if it has one) a range
+           VkPushConstantRange pushConstantRange{};
+           pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+           pushConstantRange.offset = 0;
+           pushConstantRange.size = mReflection.pushConstantSize;
+           pipelineLayoutCreateInfo.pushConstantRangeCount = pushConstantRange.size > 0 ? 1 : 0;
+           pipelineLayoutCreateInfo.pPushConstantRanges = &pushConstantRange;
         
        	   //Create pipeline layout
        	   if (vkCreatePipelineLayout(mPipelineDevice.GetDevice(), &pipelineLayoutCreateInfo, nullptr, &mPipelineLayout) 
@@ -153,6 +811,153 @@
              NL_CRITICAL("Failed to create pipeline layout");
        	   }
        	 }
+       
+         /*********************************************************************
+          * @brief: Creates the layout for this pipeline from what its shader
+          *         declares, every binding in a set goes in one descriptor 
+          *         set layout instead of one set per uniform
+         *********************************************************************/
+         void ComputePipeline::CreatePipelineLayout()
+         {
+           //Bindings are sorted by set, so each set's bindings are next to each other
+           const std::vector&ltReflectedBinding>& bindings = mReflection.bindings;
+           uint32_t setCount = bindings.empty() ? 0 : bindings.back().set + 1;
+           size_t next = 0;
+           for (uint32_t set = 0; set &lt setCount; ++set)
+           {
+             std::vector&ltVkDescriptorSetLayoutBinding> setBindings;
+             for (; next &lt bindings.size() && bindings[next].set == set; ++next)
+             {
+               VkDescriptorSetLayoutBinding layoutBinding{};
+               layoutBinding.binding = bindings[next].binding;
+               layoutBinding.descriptorType = bindings[next].descriptorType;
+               layoutBinding.descriptorCount = bindings[next].count;
+               layoutBinding.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+               setBindings.push_back(layoutBinding);
+             }
+       
+             //Sets the shader skips still need a (empty) layout to keep the numbering
+             VkDescriptorSetLayoutCreateInfo layoutInfo{};
+             layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+             layoutInfo.bindingCount = static_cast&ltuint32_t>(setBindings.size());
+             layoutInfo.pBindings = setBindings.data();
+       
+             VkDescriptorSetLayout layout = VK_NULL_HANDLE;
+             if (vkCreateDescriptorSetLayout(mPipelineDevice.GetDevice(), &layoutInfo, nullptr, &layout) != VK_SUCCESS)
+             {
+               NL_CRITICAL("Failed to create descriptor set layout for " + mPath);
+             }
+             mDescriptorSetLayouts.push_back(layout);
+           }
+       
+           //Log how many set binds are saved over one set per uniform (BindDescriptorSets counts real ones)
+           NL_INFO("Compute shader " + mPath + " packs " + std::to_string(bindings.size()) + " bindings into " + 
+                   std::to_string(setCount) + " descriptor sets");
+       
+           VkPipelineLayoutCreateInfo pipelineLayoutCreateInfo{};
+           pipelineLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+           pipelineLayoutCreateInfo.setLayoutCount = static_cast&ltuint32_t>(mDescriptorSetLayouts.size());
+           pipelineLayoutCreateInfo.pSetLayouts = mDescriptorSetLayouts.data();
+       
+           //Give the shader's push constant block (if it has one) a range
+           VkPushConstantRange pushConstantRange{};
+           pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+           pushConstantRange.offset = 0;
+           pushConstantRange.size = mReflection.pushConstantSize;
+           pipelineLayoutCreateInfo.pushConstantRangeCount = pushConstantRange.size > 0 ? 1 : 0;
+           pipelineLayoutCreateInfo.pPushConstantRanges = &pushConstantRange;
+       
+           if (vkCreatePipelineLayout(mPipelineDevice.GetDevice(), &pipelineLayoutCreateInfo, nullptr, &mPipelineLayout) 
+                != VK_SUCCESS)
+           {
+             NL_CRITICAL("Failed to create pipeline layout");
+           }
+         }
+       
+         /*********************************************************************
+          * @brief: Gets the layout of one of this pipeline's descriptor sets,
+          *         only made when the layout comes from the shader
+          *
+          * @param  set: Index of the set
+          * @return Layout of the set, VK_NULL_HANDLE if there is none
+         *********************************************************************/
+         VkDescriptorSetLayout ComputePipeline::GetDescriptorSetLayout(uint32_t set) const
+         {
+           return set &lt mDescriptorSetLayouts.size() ? mDescriptorSetLayouts[set] : VK_NULL_HANDLE;
+         }
+       
+         /*********************************************************************
+          * @brief: Gets this pipeline's layout, for binding descriptor sets 
+          *         and pushing constants
+          *
+          * @return Pipeline layout
+         *********************************************************************/
+         VkPipelineLayout ComputePipeline::GetPipelineLayout() const
+         {
+           return mPipelineLayout;
+         }
+       
+         /*********************************************************************
+          * @brief: Binds descriptor sets made from this pipeline's layouts in
+          *         one call, counting how many sets it takes against one set
+          *         per binding
+          *
+          * @param  commandBuffer: Command buffer to bind in
+          * @param  sets: Sets to bind, in set order starting from set 0
+         *********************************************************************/
+         void ComputePipeline::BindDescriptorSets(VkCommandBuffer commandBuffer, const std::vector&ltVkDescriptorSet>& sets)
+         {
+           if (sets.empty())
+           {
+             return;
+           }
+       
+           vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, mPipelineLayout, 0, 
+                                   static_cast&ltuint32_t>(sets.size()), sets.data(), 0, nullptr);
+       
+           mSetBinds += static_cast&ltint>(sets.size());
+           mNaiveSetBinds += static_cast&ltint>(mReflection.bindings.size());
+         }
+       
+         /*********************************************************************
+          * @brief: Gets how many descriptor sets BindDescriptorSets has bound,
+          *         and how many one set per binding would have needed
+          *
+          * @param  naive: Will be filled with the naive set count (ignored if
+          *                nullptr)
+          * @return Number of sets bound
+         *********************************************************************/
+         int ComputePipeline::GetSetBindCounts(int* naive) const
+         {
+           if (naive)
+           {
+             *naive = mNaiveSetBinds;
+           }
+           return mSetBinds;
+         }
+       
+         /*********************************************************************
+          * @brief: Gets the path of this pipeline's shader
+          *
+          * @return Path to compute shader code file
+         *********************************************************************/
+         const std::string& ComputePipeline::GetPath() const
+         {
+           return mPath;
+         }
+
+         /*********************************************************************
+          * @brief: Makes this pipeline's shader module and reflects it
+         *********************************************************************/
+         void ComputePipeline::LoadShader()
+         {
+           //Make shader module from cached SPIR-V, only running glslang if there is none
+           auto compileStart = std::chrono::steady_clock::now();
+           bool cached = LoadShaderModule(mPipelineDevice, mPath, &mComputeShaderModule, &mReflection);
+           std::chrono::duration&ltfloat, std::milli> compileTime = std::chrono::steady_clock::now() - compileStart;
+           NL_INFO("Loaded compute shader " + mPath + " in " + std::to_string(compileTime.count()) + "ms (" + 
+                   (cached ? "cached SPIR-V" : "compiled") + ")");
+         }
 
          /*********************************************************************
           * @brief: Creates this compute pipeline
@@ -165,32 +970,1678 @@
        	     NL_CRITICAL("Cannot create compute pipeline: no pipelineLayout provided");
            }
         
-           //Read and compile code file
-           const std::string& computeCode = ReadShader(mPath);
-           std::vector&ltuint32_t> vertShaderSPV = CompileGLSLtoSPV(computeCode, EShLangCompute);
-           CreateShaderModule(mPipelineDevice, vertShaderSPV, &mComputeShaderModule);
-        
-           //Make create infos for compute shader stage
-           VkPipelineShaderStageCreateInfo computeShaderStageInfo{};
-           computeShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO; //Set what will be created to a shader module
-           computeShaderStageInfo.stage = VK_SHADER_STAGE_COMPUTE_BIT;                         //Set type to vertex shader
-           computeShaderStageInfo.module = mComputeShaderModule;                               //Vertex shader to use
-           computeShaderStageInfo.pName = "main";                                              //Name of entry function in vertex shader
-           computeShaderStageInfo.flags = 0;                                                   //Using no flags//Using no flags
-           computeShaderStageInfo.pNext = nullptr;
-           computeShaderStageInfo.pSpecializationInfo = nullptr;
-        
            //Create pipeline object using everything we have set up
-           VkComputePipelineCreateInfo pipelineCreateInfo{};
-           pipelineCreateInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO; //Set what will be created to a graphics pipeline
-           pipelineCreateInfo.stage = computeShaderStageInfo;                         //Programable shader stages to use
-           pipelineCreateInfo.layout = mPipelineLayout;                               //Set data from config
+           VkComputePipelineCreateInfo pipelineCreateInfo = GetPipelineCreateInfo();
         
-           //Create the pipeline 
-           if (vkCreateComputePipelines(mPipelineDevice.GetDevice(), VK_NULL_HANDLE, 1, &pipelineCreateInfo, nullptr, &mComputePipeline) 
+           //Create the pipeline (cache lets the driver skip compiling what it has seen before)
+           auto start = std::chrono::steady_clock::now();
+           if (vkCreateComputePipelines(mPipelineDevice.GetDevice(), mPipelineCache, 1, &pipelineCreateInfo, nullptr, &mComputePipeline) 
                 != VK_SUCCESS)
            {
              NL_CRITICAL("Failed to create compute pipeline");
            }
+       
+           //Log creation time so cold and warm caches can be compared
+           std::chrono::duration&ltfloat, std::milli> time = std::chrono::steady_clock::now() - start;
+           NL_INFO("Created compute pipeline " + mPath + " in " + std::to_string(time.count()) + "ms (" + 
+                   (IsPipelineCacheWarm(mPipelineDevice) ? "warm" : "cold") + " cache)");
        	 }
+       
+         /*********************************************************************
+          * @brief: Fills out how to create this pipeline, needs the shader 
+          *         module and layout to already be made
+          *
+          * @param  specialization: Constants to specialize the shader with, 
+          *                         must live until the pipeline is created
+          * @param  module: Shader module to use, VK_NULL_HANDLE for this 
+          *                 pipeline's own
+          * @return Create info for vkCreateComputePipelines
+         *********************************************************************/
+         VkComputePipelineCreateInfo ComputePipeline::GetPipelineCreateInfo(const VkSpecializationInfo* specialization, 
+                                                                            VkShaderModule module) const
+         {
+           //Make create infos for compute shader stage
+           VkPipelineShaderStageCreateInfo computeShaderStageInfo{};
+           computeShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO; //Set what will be created to a shader module
+           computeShaderStageInfo.stage = VK_SHADER_STAGE_COMPUTE_BIT;                         //Set type to vertex shader
+           computeShaderStageInfo.module = module ? module : mComputeShaderModule;             //Vertex shader to use
+           computeShaderStageInfo.pName = "main";                                              //Name of entry function in vertex shader
+           computeShaderStageInfo.flags = 0;                                                   //Using no flags//Using no flags
+           computeShaderStageInfo.pNext = nullptr;
+           computeShaderStageInfo.pSpecializationInfo = specialization;
+        
+           //Create pipeline object using everything we have set up
+           VkComputePipelineCreateInfo pipelineCreateInfo{};
+           pipelineCreateInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO; //Set what will be created to a graphics pipeline
+           pipelineCreateInfo.stage = computeShaderStageInfo;                         //Programable shader stages to use
+           pipelineCreateInfo.layout = mPipelineLayout;                               //Set data from config
+       
+           return pipelineCreateInfo;
+         }
+       
+         /*********************************************************************
+          * @brief: Gets the pipeline cache shared by all compute pipelines on 
+          *         passed device, loading it from disk for the first one
+          *
+          * @param  device: Device to get the cache of
+          * @return The device's pipeline cache
+         *********************************************************************/
+         VkPipelineCache ComputePipeline::AcquirePipelineCache(Device& device)
+         {
+           std::lock_guard&ltstd::mutex> lock(sPipelineCacheMutex);
+           SharedPipelineCache& shared = sPipelineCaches[device.GetDevice()];
+       
+           //Already made by another pipeline
+           if (shared.users++ > 0)
+           {
+             return shared.cache;
+           }
+       
+           //Each gpu and driver gets its own file
+           VkPhysicalDeviceProperties properties;
+           vkGetPhysicalDeviceProperties(device.GetPhysicalDevice(), &properties);
+           shared.path = sPipelineCacheFolder + std::to_string(properties.vendorID) + "_" + 
+                         std::to_string(properties.deviceID) + ".bin";
+       
+           //Read old cache, throwing it out if a different device or driver made it
+           std::vector&ltchar> data;
+           std::ifstream file{shared.path, std::ios::ate | std::ios::binary};
+           if (file.is_open())
+           {
+             data.resize(static_cast&ltsize_t>(file.tellg()));
+             file.seekg(0);
+             file.read(data.data(), data.size());
+       
+             if (!IsPipelineCacheValid(data, properties))
+             {
+               NL_WARN("Pipeline cache " + shared.path + " is from another device or driver, starting cold");
+               data.clear();
+             }
+           }
+           shared.warm = !data.empty();
+       
+           //Make cache with whatever data survived
+           VkPipelineCacheCreateInfo createInfo{};
+           createInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+           createInfo.initialDataSize = data.size();
+           createInfo.pInitialData = data.empty() ? nullptr : data.data();
+       
+           if (vkCreatePipelineCache(device.GetDevice(), &createInfo, nullptr, &shared.cache) != VK_SUCCESS)
+           {
+             //Drivers may still reject data that passed the header check, so try again empty
+             createInfo.initialDataSize = 0;
+             createInfo.pInitialData = nullptr;
+             shared.warm = false;
+       
+             if (vkCreatePipelineCache(device.GetDevice(), &createInfo, nullptr, &shared.cache) != VK_SUCCESS)
+             {
+               NL_CRITICAL("Failed to create pipeline cache");
+             }
+           }
+       
+           return shared.cache;
+         }
+       
+         /*********************************************************************
+          * @brief: Lets go of the pipeline cache on passed device, the last 
+          *         user saves it to disk and destroys it
+          *
+          * @param  device: Device the cache belongs to
+         *********************************************************************/
+         void ComputePipeline::ReleasePipelineCache(Device& device)
+         {
+           std::lock_guard&ltstd::mutex> lock(sPipelineCacheMutex);
+           auto found = sPipelineCaches.find(device.GetDevice());
+           if (found == sPipelineCaches.end() || --found->second.users > 0)
+           {
+             return;
+           }
+       
+           WritePipelineCache(device.GetDevice(), found->second);
+           vkDestroyPipelineCache(device.GetDevice(), found->second.cache, nullptr);
+           sPipelineCaches.erase(found);
+         }
+       
+         /*********************************************************************
+          * @brief: Saves the pipeline cache on passed device to disk now 
+          *         rather than waiting for shutdown, so a crash doesn't lose it
+          *
+          * @param  device: Device whose cache to save
+         *********************************************************************/
+         void ComputePipeline::SavePipelineCache(Device& device)
+         {
+           std::lock_guard&ltstd::mutex> lock(sPipelineCacheMutex);
+           auto found = sPipelineCaches.find(device.GetDevice());
+           if (found != sPipelineCaches.end())
+           {
+             WritePipelineCache(device.GetDevice(), found->second);
+           }
+         }
+       
+         /*********************************************************************
+          * @brief: Gets if the pipeline cache on passed device started with 
+          *         data from disk
+          *
+          * @param  device: Device to check
+          * @return If the cache is warm
+         *********************************************************************/
+         bool ComputePipeline::IsPipelineCacheWarm(Device& device)
+         {
+           std::lock_guard&ltstd::mutex> lock(sPipelineCacheMutex);
+           auto found = sPipelineCaches.find(device.GetDevice());
+           return found != sPipelineCaches.end() && found->second.warm;
+         }
+       
+         /*********************************************************************
+          * @brief: Writes a pipeline cache's data to its file, caller must 
+          *         hold sPipelineCacheMutex
+          *
+          * @param  device: Device the cache belongs to
+          * @param  shared: Cache to write
+         *********************************************************************/
+         void ComputePipeline::WritePipelineCache(VkDevice device, const SharedPipelineCache& shared)
+         {
+           //Get size then data
+           size_t size = 0;
+           vkGetPipelineCacheData(device, shared.cache, &size, nullptr);
+           std::vector&ltchar> data(size);
+           if (size == 0 || vkGetPipelineCacheData(device, shared.cache, &size, data.data()) != VK_SUCCESS)
+           {
+             return;
+           }
+       
+           //Write to a temp file first so a crash mid write can't leave half a cache
+           std::error_code error;
+           std::filesystem::create_directories(sPipelineCacheFolder, error);
+           std::string tempPath = shared.path + ".tmp";
+           {
+             std::ofstream file{tempPath, std::ios::binary | std::ios::trunc};
+             if (!file.is_open())
+             {
+               NL_WARN("Failed to save pipeline cache " + shared.path);
+               return;
+             }
+             file.write(data.data(), size);
+           }
+           std::filesystem::rename(tempPath, shared.path, error);
+         }
+       
+         /*********************************************************************
+          * @brief: Checks a saved pipeline cache's header matches this device
+          *         and driver, drivers are not required to check it themselves
+          *
+          * @param  data: Saved cache data
+          * @param  properties: Properties of the device it will be used on
+          * @return If the data can be given to the driver
+         *********************************************************************/
+         bool ComputePipeline::IsPipelineCacheValid(const std::vector&ltchar>& data, const VkPhysicalDeviceProperties& properties)
+         {
+           VkPipelineCacheHeaderVersionOne header;
+           if (data.size() &lt sizeof(header))
+           {
+             return false;
+           }
+           std::memcpy(&header, data.data(), sizeof(header));
+       
+           return header.headerSize >= sizeof(header) && 
+                  header.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE && 
+                  header.vendorID == properties.vendorID && 
+                  header.deviceID == properties.deviceID && 
+                  std::memcmp(header.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+         }
+       
+         /*********************************************************************
+          * @brief: Makes a shader module for passed shader file, using its 
+          *         cached SPIR-V if it has any and compiling (then caching)
+          *         it if not
+          *
+          * @param  device: Device to make the module on
+          * @param  filePath: Path of compute shader code file
+          * @param  shaderModule: Gets set to created shader module
+          * @param  reflection: Gets filled with what the shader uses
+          * @return If cached SPIR-V was used
+         *********************************************************************/
+         bool ComputePipeline::LoadShaderModule(Device& device, 
+                                                const std::string& filePath, 
+                                                VkShaderModule* shaderModule, 
+                                                ShaderReflection* reflection)
+         {
+           const std::string& computeCode = ReadShader(filePath);
+           uint64_t key = GetSpirvCacheKey(filePath, computeCode);
+       
+           //Map cached SPIR-V and hand it to the driver without copying it
+           MappedFile file;
+           if (file.Open(GetSpirvCachePath(key)) && file.Size() >= sizeof(SpirvCacheHeader))
+           {
+             SpirvCacheHeader header;
+             std::memcpy(&header, file.Data(), sizeof(header));
+       
+             if (header.magic == SpirvCacheMagic && header.key == key && 
+                 file.Size() == sizeof(header) + header.words * sizeof(uint32_t))
+             {
+               const uint32_t* code = reinterpret_cast&ltconst uint32_t*>(file.Data() + sizeof(header));
+               CreateShaderModule(device, code, header.words, shaderModule);
+               *reflection = ReflectShader(code, header.words);
+               return true;
+             }
+       
+             NL_WARN("Cached SPIR-V for " + filePath + " is damaged, recompiling");
+           }
+       
+           //Not cached yet, only cache it if it compiled so the next run tries again
+           std::vector&ltuint32_t> computeSPV = CompileGLSLtoSPV(computeCode, EShLangCompute);
+           if (computeSPV.empty())
+           {
+             NL_ERROR("Compute shader " + filePath + " failed to compile");
+           }
+           else
+           {
+             WriteSpirvCache(key, computeSPV);
+           }
+           CreateShaderModule(device, computeSPV, shaderModule);
+           *reflection = ReflectShader(computeSPV.data(), computeSPV.size());
+           return false;
+         }
+       
+         /*********************************************************************
+          * @brief: Compiles passed shader file into the SPIR-V cache without 
+          *         needing a device, for running as a build step so the game
+          *         never has to run glslang at startup
+          *
+          * @param  filePath: Path of compute shader code file
+          * @return If the shader is now cached (false if compiling failed)
+         *********************************************************************/
+         bool ComputePipeline::PrecompileShader(const std::string& filePath)
+         {
+           const std::string& computeCode = ReadShader(filePath);
+           uint64_t key = GetSpirvCacheKey(filePath, computeCode);
+       
+           //Already up to date
+           if (std::filesystem::exists(GetSpirvCachePath(key)))
+           {
+             return true;
+           }
+       
+           std::vector&ltuint32_t> computeSPV = CompileGLSLtoSPV(computeCode, EShLangCompute);
+           if (computeSPV.empty())
+           {
+             return false;
+           }
+       
+           WriteSpirvCache(key, computeSPV);
+           return true;
+         }
+       
+         /*********************************************************************
+          * @brief: Makes the key cached SPIR-V is found by, hashing 
+          *         everything that changes what glslang outputs: the source,
+          *         every file it includes, the stage and the compiler version
+          *
+          * @param  filePath: Path of compute shader code file
+          * @param  source: Code of the file
+          * @return Key of the shader's SPIR-V
+         *********************************************************************/
+         uint64_t ComputePipeline::GetSpirvCacheKey(const std::string& filePath, const std::string& source)
+         {
+           static const std::string compilerVersion = GetSpirvCompilerVersion();
+           uint64_t hash = HashBytes(compilerVersion.data(), compilerVersion.size());
+           EShLanguage stage = EShLangCompute;
+           hash = HashBytes(&stage, sizeof(stage), hash);
+           hash = HashBytes(source.data(), source.size(), hash);
+       
+           //Hash included files too (a change to one has to rebuild everything that includes it), 
+           //each file's includes are found from the folder that file is in
+           std::vector&ltstd::pair&ltstd::string, std::filesystem::path>> pending = { { source, std::filesystem::path(filePath).parent_path() } };
+           std::vector&ltstd::string> seen;
+           while (!pending.empty())
+           {
+             std::istringstream stream(pending.back().first);
+             std::filesystem::path folder = pending.back().second;
+             pending.pop_back();
+       
+             std::string line;
+             while (std::getline(stream, line))
+             {
+               size_t include = line.find("#include");
+               size_t open = line.find('"', include);
+               size_t close = line.find('"', open + 1);
+               if (include == std::string::npos || open == std::string::npos || close == std::string::npos)
+               {
+                 continue;
+               }
+       
+               //Only hash each file once, which also stops include loops
+               std::filesystem::path includePath = (folder / line.substr(open + 1, close - open - 1)).lexically_normal();
+               std::string path = includePath.string();
+               if (std::find(seen.begin(), seen.end(), path) != seen.end())
+               {
+                 continue;
+               }
+               seen.push_back(path);
+       
+               std::ifstream file{path, std::ios::binary};
+               std::string included((std::istreambuf_iterator&ltchar>(file)), std::istreambuf_iterator&ltchar>());
+               hash = HashBytes(path.data(), path.size(), hash);
+               hash = HashBytes(included.data(), included.size(), hash);
+               pending.push_back({ included, includePath.parent_path() });
+             }
+           }
+       
+           return hash;
+         }
+       
+         /*********************************************************************
+          * @brief: Gets the file SPIR-V with passed key is cached in
+          *
+          * @param  key: Key from GetSpirvCacheKey
+          * @return Path of the cache file
+         *********************************************************************/
+         std::string ComputePipeline::GetSpirvCachePath(uint64_t key)
+         {
+           std::ostringstream name;
+           name &lt&lt sSpirvCacheFolder &lt&lt std::hex &lt&lt key &lt&lt ".spv";
+           return name.str();
+         }
+       
+         /*********************************************************************
+          * @brief: Saves compiled SPIR-V to the cache
+          *
+          * @param  key: Key from GetSpirvCacheKey
+          * @param  code: Compiled SPIR-V
+         *********************************************************************/
+         void ComputePipeline::WriteSpirvCache(uint64_t key, const std::vector&ltuint32_t>& code)
+         {
+           SpirvCacheHeader header;
+           header.magic = SpirvCacheMagic;
+           header.words = static_cast&ltuint32_t>(code.size());
+           header.key = key;
+       
+           //Write to a temp file first so other processes never map half a file
+           std::error_code error;
+           std::filesystem::create_directories(sSpirvCacheFolder, error);
+           std::string path = GetSpirvCachePath(key);
+           std::string tempPath = path + "." + std::to_string(std::chrono::steady_clock::now().time_since_epoch().count()) + ".tmp";
+           {
+             std::ofstream file{tempPath, std::ios::binary | std::ios::trunc};
+             if (!file.is_open())
+             {
+               NL_WARN("Failed to save SPIR-V cache " + path);
+               return;
+             }
+             file.write(reinterpret_cast&ltconst char*>(&header), sizeof(header));
+             file.write(reinterpret_cast&ltconst char*>(code.data()), code.size() * sizeof(uint32_t));
+           }
+           std::filesystem::rename(tempPath, path, error);
+         }
+       
+         /*********************************************************************
+          * @brief: Sets an int specialization constant
+          *
+          * @param  id: constant_id of the constant in the shader
+          * @param  value: Value to set it to
+          * @return These constants, so sets can be chained
+         *********************************************************************/
+         SpecializationConstants& SpecializationConstants::Set(uint32_t id, int32_t value)
+         {
+           return SetBytes(id, &value, sizeof(value));
+         }
+       
+         /*********************************************************************
+          * @brief: Sets a uint specialization constant
+          *
+          * @param  id: constant_id of the constant in the shader
+          * @param  value: Value to set it to
+          * @return These constants, so sets can be chained
+         *********************************************************************/
+         SpecializationConstants& SpecializationConstants::Set(uint32_t id, uint32_t value)
+         {
+           return SetBytes(id, &value, sizeof(value));
+         }
+       
+         /*********************************************************************
+          * @brief: Sets a float specialization constant
+          *
+          * @param  id: constant_id of the constant in the shader
+          * @param  value: Value to set it to
+          * @return These constants, so sets can be chained
+         *********************************************************************/
+         SpecializationConstants& SpecializationConstants::Set(uint32_t id, float value)
+         {
+           return SetBytes(id, &value, sizeof(value));
+         }
+       
+         /*********************************************************************
+          * @brief: Sets a bool specialization constant
+          *
+          * @param  id: constant_id of the constant in the shader
+          * @param  value: Value to set it to
+          * @return These constants, so sets can be chained
+         *********************************************************************/
+         SpecializationConstants& SpecializationConstants::Set(uint32_t id, bool value)
+         {
+           //Shader bools are 32 bits
+           VkBool32 boolValue = value ? 1 : 0;
+           return SetBytes(id, &boolValue, sizeof(boolValue));
+         }
+       
+         /*********************************************************************
+          * @brief: Sets the work group size, shader must declare it with
+          *         layout(local_size_x_id = 0, local_size_y_id = 1, 
+          *         local_size_z_id = 2) in;
+          *
+          * @param  x: Work group size in x
+          * @param  y: Work group size in y
+          * @param  z: Work group size in z
+          * @return These constants, so sets can be chained
+         *********************************************************************/
+         SpecializationConstants& SpecializationConstants::SetLocalSize(uint32_t x, uint32_t y, uint32_t z)
+         {
+           return Set(LocalSizeXID, x).Set(LocalSizeYID, y).Set(LocalSizeZID, z);
+         }
+       
+         /*********************************************************************
+          * @brief: Gets the key variants with these constants are cached by, 
+          *         the same values give the same key in any order they're set
+          *
+          * @return Key of these constants
+         *********************************************************************/
+         uint64_t SpecializationConstants::GetKey() const
+         {
+           //Entries are kept sorted by id
+           uint64_t hash = HashBytes(nullptr, 0);
+           for (const VkSpecializationMapEntry& entry : mEntries)
+           {
+             hash = HashBytes(&entry.constantID, sizeof(entry.constantID), hash);
+             hash = HashBytes(mData.data() + entry.offset, entry.size, hash);
+           }
+           return hash;
+         }
+       
+         /*********************************************************************
+          * @brief: Gets these constants in the form Vulkan takes, points into
+          *         these constants so they must outlive it
+          *
+          * @return Specialization info of these constants
+         *********************************************************************/
+         VkSpecializationInfo SpecializationConstants::GetInfo() const
+         {
+           VkSpecializationInfo info{};
+           info.mapEntryCount = static_cast&ltuint32_t>(mEntries.size());
+           info.pMapEntries = mEntries.data();
+           info.dataSize = mData.size();
+           info.pData = mData.data();
+           return info;
+         }
+       
+         /*********************************************************************
+          * @brief: Gets if no constants have been set
+          *
+          * @return If there are no constants
+         *********************************************************************/
+         bool SpecializationConstants::Empty() const
+         {
+           return mEntries.empty();
+         }
+       
+         /*********************************************************************
+          * @brief: Sets a constant's raw value, replacing it if already set
+          *
+          * @param  id: constant_id of the constant in the shader
+          * @param  value: Value to set it to
+          * @param  size: Size of the value in bytes
+          * @return These constants, so sets can be chained
+         *********************************************************************/
+         SpecializationConstants& SpecializationConstants::SetBytes(uint32_t id, const void* value, size_t size)
+         {
+           //Find where id goes to keep entries sorted
+           auto entry = std::lower_bound(mEntries.begin(), mEntries.end(), id, 
+                                         [](const VkSpecializationMapEntry& e, uint32_t i) { return e.constantID &lt i; });
+       
+           //Overwrite old value (every type is 32 bits so the size always matches)
+           if (entry != mEntries.end() && entry->constantID == id && entry->size == size)
+           {
+             std::memcpy(mData.data() + entry->offset, value, size);
+             return *this;
+           }
+       
+           //Add new value to the end of the data
+           VkSpecializationMapEntry newEntry{};
+           newEntry.constantID = id;
+           newEntry.offset = static_cast&ltuint32_t>(mData.size());
+           newEntry.size = size;
+           mData.insert(mData.end(), static_cast&ltconst char*>(value), static_cast&ltconst char*>(value) + size);
+       
+           if (entry != mEntries.end() && entry->constantID == id)
+           {
+             *entry = newEntry;
+           }
+           else
+           {
+             mEntries.insert(entry, newEntry);
+           }
+           return *this;
+         }
+       
+         /*********************************************************************
+          * @brief: Reads what a shader needs from the pipeline layout out of
+          *         its SPIR-V, so it doesn't have to be declared by hand
+          *
+          * @param  code: SPIR-V of the shader
+          * @param  words: Number of 32 bit words in code
+          * @return What the shader uses
+         *********************************************************************/
+         ShaderReflection ComputePipeline::ReflectShader(const uint32_t* code, size_t words)
+         {
+           ShaderReflection reflection;
+           SpirvModule module;
+           if (!module.Parse(code, words))
+           {
+             NL_ERROR("Failed to reflect compute shader: not valid SPIR-V");
+             return reflection;
+           }
+       
+           for (const SpirvModule::Variable& variable : module.variables)
+           {
+             //Every global is a pointer to its real type
+             auto pointer = module.types.find(variable.type);
+             if (pointer == module.types.end() || pointer->second.size() &lt 4)
+             {
+               continue;
+             }
+             uint32_t pointee = pointer->second[3];
+       
+             //Push constant block is a pointer to a struct
+             if (variable.storageClass == StoragePushConstant)
+             {
+               reflection.pushConstantSize = module.Size(pointee);
+               continue;
+             }
+       
+             //Everything else a shader reads from outside is a descriptor
+             if (variable.storageClass != StorageUniformConstant && variable.storageClass != StorageUniform && 
+                 variable.storageClass != StorageStorageBuffer)
+             {
+               continue;
+             }
+       
+             ReflectedBinding binding;
+             binding.set = module.Decoration(variable.id, DecorationDescriptorSet);
+             binding.binding = module.Decoration(variable.id, DecorationBinding);
+             binding.count = 1;
+       
+             //Arrays of descriptors are one binding with a count
+             auto type = module.types.find(pointee);
+             while (type != module.types.end() && 
+                    (type->second[0] == OpTypeArray || type->second[0] == OpTypeRuntimeArray))
+             {
+               if (type->second[0] == OpTypeArray)
+               {
+                 auto length = module.constants.find(type->second[3]);
+                 binding.count *= length == module.constants.end() ? 1 : length->second;
+               }
+               pointee = type->second[2];
+               type = module.types.find(pointee);
+             }
+             if (type == module.types.end())
+             {
+               continue;
+             }
+       
+             //Work out which kind of descriptor it is
+             switch (type->second[0])
+             {
+             case OpTypeStruct:
+               //Old style storage buffers are Uniform structs marked BufferBlock
+               binding.descriptorType = variable.storageClass == StorageStorageBuffer || 
+                                        module.Decoration(pointee, DecorationBufferBlock) ? 
+                                        VK_DESCRIPTOR_TYPE_STORAGE_BUFFER : VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+               break;
+             case OpTypeImage:
+             {
+               bool storage = type->second[7] == ImageStorage;
+               bool texelBuffer = type->second[3] == DimBuffer;
+               if (texelBuffer)
+               {
+                 binding.descriptorType = storage ? VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER : VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER;
+               }
+               else
+               {
+                 binding.descriptorType = storage ? VK_DESCRIPTOR_TYPE_STORAGE_IMAGE : VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+               }
+               break;
+             }
+             case OpTypeSampler:
+               binding.descriptorType = VK_DESCRIPTOR_TYPE_SAMPLER;
+               break;
+             case OpTypeSampledImage:
+               binding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+               break;
+             default:
+               continue;
+             }
+       
+             reflection.bindings.push_back(binding);
+           }
+       
+           //Sorted by set then binding so layouts can be built in one pass
+           std::sort(reflection.bindings.begin(), reflection.bindings.end(), 
+                     [](const ReflectedBinding& a, const ReflectedBinding& b) 
+                     { return a.set != b.set ? a.set &lt b.set : a.binding &lt b.binding; });
+       
+           //Aliased variables share a set and binding, they are one descriptor so only keep one
+           std::vector&ltReflectedBinding> merged;
+           for (const ReflectedBinding& binding : reflection.bindings)
+           {
+             if (merged.empty() || merged.back().set != binding.set || merged.back().binding != binding.binding)
+             {
+               merged.push_back(binding);
+               continue;
+             }
+       
+             if (merged.back().descriptorType != binding.descriptorType)
+             {
+               NL_ERROR("Compute shader aliases set " + std::to_string(binding.set) + " binding " + 
+                        std::to_string(binding.binding) + " as different descriptor types");
+             }
+             merged.back().count = std::max(merged.back().count, binding.count);
+           }
+           reflection.bindings.swap(merged);
+       
+           //Every device has at least 128 bytes, more isn't safe to count on
+           if (reflection.pushConstantSize > 128)
+           {
+             NL_WARN("Compute shader push constant block is " + std::to_string(reflection.pushConstantSize) + 
+                     " bytes, only 128 are guaranteed");
+           }
+       
+           return reflection;
+         }
+       
+         /*********************************************************************
+          * @brief: Creates a recorder that records compute dispatches into 
+          *         passed command buffer, adding only the barriers needed
+          *
+          * @param  commandBuffer: Command buffer to record into (must be 
+          *                        recording already)
+         *********************************************************************/
+         ComputeRecorder::ComputeRecorder(VkCommandBuffer commandBuffer)
+           : mCommandBuffer(commandBuffer)
+         {
+         }
+       
+         /*********************************************************************
+          * @brief: Gets the id the recorder tracks a buffer by
+          *
+          * @param  buffer: Buffer to track
+          * @return Id of the buffer
+         *********************************************************************/
+         uint64_t ComputeRecorder::Resource(VkBuffer buffer)
+         {
+           //Handles are pointers on 64 bit and integers on 32 bit, this cast works for both
+           return (uint64_t)buffer;
+         }
+       
+         /*********************************************************************
+          * @brief: Gets the id the recorder tracks an image by, images must be
+          *         in VK_IMAGE_LAYOUT_GENERAL as storage images are
+          *
+          * @param  image: Image to track
+          * @return Id of the image
+         *********************************************************************/
+         uint64_t ComputeRecorder::Resource(VkImage image)
+         {
+           return (uint64_t)image;
+         }
+       
+         /*********************************************************************
+          * @brief: Records a dispatch, first adding a barrier if it touches
+          *         anything an earlier dispatch is still using
+          *
+          * @param  pipeline: Pipeline to dispatch
+          * @param  x: Number of work groups in x
+          * @param  y: Number of work groups in y
+          * @param  z: Number of work groups in z
+          * @param  reads: Resources the dispatch reads (from Resource)
+          * @param  writes: Resources the dispatch writes (from Resource)
+         *********************************************************************/
+         void ComputeRecorder::Dispatch(ComputePipeline& pipeline, 
+                                        uint32_t x, uint32_t y, uint32_t z, 
+                                        const std::vector&ltuint64_t>& reads, 
+                                        const std::vector&ltuint64_t>& writes)
+         {
+           PrepareDispatch(pipeline, reads, writes, 0);
+           vkCmdDispatch(mCommandBuffer, x, y, z);
+         }
+       
+         /*********************************************************************
+          * @brief: Records a dispatch that reads its work group counts from a
+          *         buffer, so earlier dispatches can decide how much work it 
+          *         does without the cpu waiting on them
+          *
+          * @param  pipeline: Pipeline to dispatch
+          * @param  argumentBuffer: Buffer holding a VkDispatchIndirectCommand
+          * @param  offset: Byte offset of the command in the buffer
+          * @param  reads: Resources the dispatch reads (from Resource)
+          * @param  writes: Resources the dispatch writes (from Resource)
+         *********************************************************************/
+         void ComputeRecorder::DispatchIndirect(ComputePipeline& pipeline, 
+                                                VkBuffer argumentBuffer, 
+                                                VkDeviceSize offset, 
+                                                const std::vector&ltuint64_t>& reads, 
+                                                const std::vector&ltuint64_t>& writes)
+         {
+           PrepareDispatch(pipeline, reads, writes, Resource(argumentBuffer));
+           vkCmdDispatchIndirect(mCommandBuffer, argumentBuffer, offset);
+         }
+       
+         /*********************************************************************
+          * @brief: Makes compute writes visible to whatever uses them after 
+          *         the recorded dispatches, call once when done recording
+          *
+          * @param  stage: Stages that use the results next
+          * @param  access: How those stages use them
+         *********************************************************************/
+         void ComputeRecorder::Finish(VkPipelineStageFlags2 stage, VkAccessFlags2 access)
+         {
+           if (!mPendingWrites.empty())
+           {
+             Barrier(stage, access);
+           }
+         }
+       
+         /*********************************************************************
+          * @brief: Gets how many barriers were recorded, and how many a 
+          *         barrier after every dispatch would have needed
+          *
+          * @param  naive: Will be filled with the naive barrier count 
+          *                (ignored if nullptr)
+          * @return Number of barriers recorded
+         *********************************************************************/
+         int ComputeRecorder::GetBarrierCounts(int* naive) const
+         {
+           if (naive)
+           {
+             *naive = std::max(mDispatchCount - 1, 0);
+           }
+           return mBarrierCount;
+         }
+       
+         /*********************************************************************
+          * @brief: Binds the pipeline and adds a barrier if the next dispatch
+          *         depends on, or would overwrite, anything still in use
+          *
+          * @param  pipeline: Pipeline to dispatch
+          * @param  reads: Resources the dispatch reads
+          * @param  writes: Resources the dispatch writes
+          * @param  indirect: Argument buffer of an indirect dispatch (0 if none)
+         *********************************************************************/
+         void ComputeRecorder::PrepareDispatch(ComputePipeline& pipeline, 
+                                               const std::vector&ltuint64_t>& reads, 
+                                               const std::vector&ltuint64_t>& writes, 
+                                               uint64_t indirect)
+         {
+           //Read after write and write after write need the earlier writes made visible
+           bool hazard = false;
+           for (uint64_t resource : reads)
+           {
+             hazard = hazard || mPendingWrites.count(resource);
+           }
+           for (uint64_t resource : writes)
+           {
+             hazard = hazard || mPendingWrites.count(resource) || mPendingReads.count(resource);
+           }
+       
+           //Argument buffers are read by the indirect stage, not the shader
+           bool indirectHazard = indirect != 0 && mPendingWrites.count(indirect);
+       
+           //One global barrier covers every hazard at once
+           if (hazard || indirectHazard)
+           {
+             VkPipelineStageFlags2 stage = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
+             VkAccessFlags2 access = VK_ACCESS_2_SHADER_STORAGE_READ_BIT | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT;
+             if (indirectHazard)
+             {
+               stage |= VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT;
+               access |= VK_ACCESS_2_INDIRECT_COMMAND_READ_BIT;
+             }
+             Barrier(stage, access);
+           }
+       
+           //Remember what is in use until the next barrier, and which stages use it
+           mPendingReads.insert(reads.begin(), reads.end());
+           mPendingWrites.insert(writes.begin(), writes.end());
+           mPendingStages |= VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
+           if (!writes.empty())
+           {
+             mPendingAccess |= VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT;
+           }
+           if (indirect != 0)
+           {
+             mPendingReads.insert(indirect);
+             mPendingStages |= VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT;
+           }
+       
+           //Only rebind when the pipeline changes
+           if (mBoundPipeline != &pipeline)
+           {
+             pipeline.Bind(mCommandBuffer);
+             mBoundPipeline = &pipeline;
+           }
+           ++mDispatchCount;
+         }
+       
+         /*********************************************************************
+          * @brief: Records a barrier from every stage the dispatches so far 
+          *         used (including indirect argument reads) to passed stages,
+          *         then forgets what was in use
+          *
+          * @param  stage: Stages that have to wait
+          * @param  access: What those stages do that has to see the writes
+         *********************************************************************/
+         void ComputeRecorder::Barrier(VkPipelineStageFlags2 stage, VkAccessFlags2 access)
+         {
+           //A memory barrier is as fast as per buffer barriers on real hardware and covers everything,
+           //reads only need to finish before the next write so they add stages but no access
+           VkMemoryBarrier2 memoryBarrier{};
+           memoryBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2;
+           memoryBarrier.srcStageMask = mPendingStages;
+           memoryBarrier.srcAccessMask = mPendingAccess;
+           memoryBarrier.dstStageMask = stage;
+           memoryBarrier.dstAccessMask = access;
+       
+           VkDependencyInfo dependencyInfo{};
+           dependencyInfo.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
+           dependencyInfo.memoryBarrierCount = 1;
+           dependencyInfo.pMemoryBarriers = &memoryBarrier;
+           vkCmdPipelineBarrier2(mCommandBuffer, &dependencyInfo);
+       
+           mPendingReads.clear();
+           mPendingWrites.clear();
+           mPendingStages = 0;
+           mPendingAccess = 0;
+           ++mBarrierCount;
+         }
+       
+         /*********************************************************************
+          * @brief: Creates a queue to submit compute work to, separate from
+          *         graphics when the device has a compute only family and
+          *         Device made a queue in it, the graphics queue otherwise
+          *         (submits to a shared queue must not overlap graphics ones
+          *         on other threads), Device must have enabled the features
+          *         HasRequiredFeatures checks
+          *
+          * @param  device: Device to submit on
+          * @param  createdFamilies: Families Device made a queue in
+          * @param  graphicsFamily: Family of Device's graphics queue
+         *********************************************************************/
+         ComputeQueue::ComputeQueue(Device& device, const std::vector&ltuint32_t>& createdFamilies, uint32_t graphicsFamily)
+           : mDevice(device)
+         {
+           if (!HasRequiredFeatures(device.GetPhysicalDevice()))
+           {
+             NL_CRITICAL("Compute queue needs the timelineSemaphore and synchronization2 features");
+           }
+       
+           //Only a family Device made a queue in can be used, asking for any other queue is invalid
+           mFamily = FindQueueFamily(device.GetPhysicalDevice(), &mDedicated);
+           if (std::find(createdFamilies.begin(), createdFamilies.end(), mFamily) == createdFamilies.end())
+           {
+             if (mDedicated)
+             {
+               NL_WARN("Device has no queue in compute family " + std::to_string(mFamily) + ", using the graphics queue");
+             }
+             mFamily = graphicsFamily;
+             mDedicated = false;
+           }
+           vkGetDeviceQueue(device.GetDevice(), mFamily, 0, &mQueue);
+       
+           if (!mDedicated)
+           {
+             NL_INFO("No dedicated compute queue, compute will share the graphics queue");
+           }
+       
+           //Command buffers get reset one at a time as they're reused
+           VkCommandPoolCreateInfo poolInfo{};
+           poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+           poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+           poolInfo.queueFamilyIndex = mFamily;
+           if (vkCreateCommandPool(device.GetDevice(), &poolInfo, nullptr, &mCommandPool) != VK_SUCCESS)
+           {
+             NL_CRITICAL("Failed to create compute command pool");
+           }
+       
+           //One timeline semaphore counts every submission, value n means submission n is done
+           VkSemaphoreTypeCreateInfo typeInfo{};
+           typeInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+           typeInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+           typeInfo.initialValue = 0;
+       
+           VkSemaphoreCreateInfo semaphoreInfo{};
+           semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+           semaphoreInfo.pNext = &typeInfo;
+           if (vkCreateSemaphore(device.GetDevice(), &semaphoreInfo, nullptr, &mTimeline) != VK_SUCCESS)
+           {
+             NL_CRITICAL("Failed to create compute timeline semaphore");
+           }
+         }
+       
+         /*********************************************************************
+          * @brief: Waits for all submitted work then destroys the queue's 
+          *         objects
+         *********************************************************************/
+         ComputeQueue::~ComputeQueue()
+         {
+           Wait(mSubmitted);
+       
+           vkDestroySemaphore(mDevice.GetDevice(), mTimeline, nullptr);
+           vkDestroyCommandPool(mDevice.GetDevice(), mCommandPool, nullptr);
+         }
+       
+         /*********************************************************************
+          * @brief: Picks the queue family compute work should go to, Device 
+          *         should make a queue in it when it is created (the queue
+          *         falls back to graphics if it doesn't)
+          *
+          * @param  physicalDevice: Device to pick from
+          * @param  dedicated: Set to if the family is compute only (ignored 
+          *                    if nullptr)
+          * @return Index of the queue family
+         *********************************************************************/
+         uint32_t ComputeQueue::FindQueueFamily(VkPhysicalDevice physicalDevice, bool* dedicated)
+         {
+           uint32_t count = 0;
+           vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &count, nullptr);
+           std::vector&ltVkQueueFamilyProperties> families(count);
+           vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &count, families.data());
+       
+           //Compute without graphics runs alongside the graphics queue
+           uint32_t shared = 0;
+           bool foundShared = false;
+           for (uint32_t i = 0; i &lt count; ++i)
+           {
+             bool compute = families[i].queueFlags & VK_QUEUE_COMPUTE_BIT;
+             bool graphics = families[i].queueFlags & VK_QUEUE_GRAPHICS_BIT;
+       
+             if (compute && !graphics)
+             {
+               if (dedicated) *dedicated = true;
+               return i;
+             }
+       
+             //Otherwise fall back to the first family that does both (every device has one)
+             if (compute && graphics && !foundShared)
+             {
+               shared = i;
+               foundShared = true;
+             }
+           }
+       
+           if (dedicated) *dedicated = false;
+           return shared;
+         }
+       
+         /*********************************************************************
+          * @brief: Checks if a device supports what the queue needs, both are
+          *         off unless enabled when the device is created: timeline 
+          *         semaphores (Vulkan 1.2) for Submit/Wait and 
+          *         synchronization2 (Vulkan 1.3) for vkQueueSubmit2 and the
+          *         recorder's barriers, neither implies the other
+          *
+          * @param  physicalDevice: Device to check
+          * @return If both features are supported
+         *********************************************************************/
+         bool ComputeQueue::HasRequiredFeatures(VkPhysicalDevice physicalDevice)
+         {
+           VkPhysicalDeviceVulkan13Features features13{};
+           features13.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES;
+       
+           VkPhysicalDeviceVulkan12Features features12{};
+           features12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+           features12.pNext = &features13;
+       
+           VkPhysicalDeviceFeatures2 features{};
+           features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+           features.pNext = &features12;
+           vkGetPhysicalDeviceFeatures2(physicalDevice, &features);
+       
+           return features12.timelineSemaphore == VK_TRUE && features13.synchronization2 == VK_TRUE;
+         }
+       
+         /*********************************************************************
+          * @brief: Times frames with compute waited on right after it is 
+          *         submitted (as if it were on the graphics queue) against 
+          *         frames that leave it running, to see what the queue saves
+          *
+          * @param  frame: Records and submits one frame, compute through 
+          *                passed queue and graphics as usual
+          * @param  frames: Number of frames to time each way
+          * @param  serialized: Will be filled with average ms per frame when
+          *                     waiting on compute
+          * @param  overlapped: Will be filled with average ms per frame when
+          *                     not waiting
+         *********************************************************************/
+         void ComputeQueue::CompareFrameTimes(const std::function&ltvoid(ComputeQueue& queue)>& frame, 
+                                              int frames, 
+                                              float* serialized, 
+                                              float* overlapped)
+         {
+           for (int pass = 0; pass &lt 2; ++pass)
+           {
+             bool overlap = pass == 1;
+             Wait(mSubmitted);
+       
+             auto start = std::chrono::steady_clock::now();
+             for (int i = 0; i &lt frames; ++i)
+             {
+               frame(*this);
+               if (!overlap)
+               {
+                 Wait(mSubmitted);
+               }
+             }
+             Wait(mSubmitted);
+       
+             std::chrono::duration&ltfloat, std::milli> time = std::chrono::steady_clock::now() - start;
+             *(overlap ? overlapped : serialized) = time.count() / std::max(frames, 1);
+           }
+       
+           NL_INFO("Compute queue frame time: " + std::to_string(*serialized) + "ms waiting on compute, " + 
+                   std::to_string(*overlapped) + "ms overlapped" + (mDedicated ? "" : " (shared queue)"));
+         }
+       
+         /*********************************************************************
+          * @brief: Gets a command buffer to record compute work into, reusing
+          *         one the gpu has finished with when there is one
+          *
+          * @return Command buffer that is recording
+         *********************************************************************/
+         VkCommandBuffer ComputeQueue::Begin()
+         {
+           VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+       
+           //Oldest submission finishes first, so only it needs checking
+           if (!mInFlight.empty() && IsComplete(mInFlight.front().value))
+           {
+             commandBuffer = mInFlight.front().commandBuffer;
+             mInFlight.pop_front();
+             vkResetCommandBuffer(commandBuffer, 0);
+           }
+           else
+           {
+             VkCommandBufferAllocateInfo allocateInfo{};
+             allocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+             allocateInfo.commandPool = mCommandPool;
+             allocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+             allocateInfo.commandBufferCount = 1;
+             if (vkAllocateCommandBuffers(mDevice.GetDevice(), &allocateInfo, &commandBuffer) != VK_SUCCESS)
+             {
+               NL_CRITICAL("Failed to allocate compute command buffer");
+             }
+           }
+       
+           VkCommandBufferBeginInfo beginInfo{};
+           beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+           beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+           vkBeginCommandBuffer(commandBuffer, &beginInfo);
+       
+           return commandBuffer;
+         }
+       
+         /*********************************************************************
+          * @brief: Ends and submits a command buffer from Begin, graphics can
+          *         wait on the returned value with GetTimelineSemaphore so 
+          *         the two queues overlap until the results are needed
+          *
+          * @param  commandBuffer: Command buffer from Begin
+          * @param  waitSemaphore: Timeline semaphore to wait on first, like
+          *                        one graphics signals (VK_NULL_HANDLE for none)
+          * @param  waitValue: Value of waitSemaphore to wait for
+          * @return Timeline value that is reached when the work is done
+         *********************************************************************/
+         uint64_t ComputeQueue::Submit(VkCommandBuffer commandBuffer, VkSemaphore waitSemaphore, uint64_t waitValue)
+         {
+           vkEndCommandBuffer(commandBuffer);
+           uint64_t value = ++mSubmitted;
+       
+           VkCommandBufferSubmitInfo commandInfo{};
+           commandInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_SUBMIT_INFO;
+           commandInfo.commandBuffer = commandBuffer;
+       
+           VkSemaphoreSubmitInfo waitInfo{};
+           waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO;
+           waitInfo.semaphore = waitSemaphore;
+           waitInfo.value = waitValue;
+           waitInfo.stageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
+       
+           VkSemaphoreSubmitInfo signalInfo{};
+           signalInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO;
+           signalInfo.semaphore = mTimeline;
+           signalInfo.value = value;
+           signalInfo.stageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+       
+           VkSubmitInfo2 submitInfo{};
+           submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO_2;
+           submitInfo.waitSemaphoreInfoCount = waitSemaphore != VK_NULL_HANDLE ? 1 : 0;
+           submitInfo.pWaitSemaphoreInfos = &waitInfo;
+           submitInfo.commandBufferInfoCount = 1;
+           submitInfo.pCommandBufferInfos = &commandInfo;
+           submitInfo.signalSemaphoreInfoCount = 1;
+           submitInfo.pSignalSemaphoreInfos = &signalInfo;
+       
+           if (vkQueueSubmit2(mQueue, 1, &submitInfo, VK_NULL_HANDLE) != VK_SUCCESS)
+           {
+             NL_CRITICAL("Failed to submit compute work");
+           }
+       
+           mInFlight.push_back({ commandBuffer, value });
+           return value;
+         }
+       
+         /*********************************************************************
+          * @brief: Checks if submitted work is done without waiting
+          *
+          * @param  value: Value from Submit
+          * @return If the work is done
+         *********************************************************************/
+         bool ComputeQueue::IsComplete(uint64_t value) const
+         {
+           uint64_t signaled = 0;
+           vkGetSemaphoreCounterValue(mDevice.GetDevice(), mTimeline, &signaled);
+           return signaled >= value;
+         }
+       
+         /*********************************************************************
+          * @brief: Blocks until submitted work is done
+          *
+          * @param  value: Value from Submit
+          * @param  timeout: Most nanoseconds to wait
+          * @return If the work is done (false if it timed out)
+         *********************************************************************/
+         bool ComputeQueue::Wait(uint64_t value, uint64_t timeout) const
+         {
+           VkSemaphoreWaitInfo waitInfo{};
+           waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+           waitInfo.semaphoreCount = 1;
+           waitInfo.pSemaphores = &mTimeline;
+           waitInfo.pValues = &value;
+       
+           return vkWaitSemaphores(mDevice.GetDevice(), &waitInfo, timeout) == VK_SUCCESS;
+         }
+       
+         /*********************************************************************
+          * @brief: Gets the semaphore submissions signal, for graphics 
+          *         submissions to wait on
+          *
+          * @return Timeline semaphore of this queue
+         *********************************************************************/
+         VkSemaphore ComputeQueue::GetTimelineSemaphore() const
+         {
+           return mTimeline;
+         }
+       
+         /*********************************************************************
+          * @brief: Gets if work runs on its own queue rather than sharing the 
+          *         graphics one, buffers used by both queues need 
+          *         VK_SHARING_MODE_CONCURRENT when it does
+          *
+          * @return If the queue is dedicated to compute
+         *********************************************************************/
+         bool ComputeQueue::IsDedicated() const
+         {
+           return mDedicated;
+         }
+       
+         /*********************************************************************
+          * @brief: Gets the family this queue is from
+          *
+          * @return Index of the queue family
+         *********************************************************************/
+         uint32_t ComputeQueue::GetFamily() const
+         {
+           return mFamily;
+         }
+       
+         /*********************************************************************
+          * @brief: Creates a profiler that times named scopes of gpu work,
+          *         with one query pool per frame in flight so reading results
+          *         never waits on the gpu
+          *
+          * @param  device: Device to time work on
+          * @param  queueFamily: Family of the queue the timed work goes to
+          * @param  framesInFlight: Frames the gpu can be behind the cpu
+          * @param  maxScopes: Most scopes that can be timed in one frame
+         *********************************************************************/
+         ComputeProfiler::ComputeProfiler(Device& device, uint32_t queueFamily, uint32_t framesInFlight, uint32_t maxScopes)
+           : mDevice(device)
+           , mMaxScopes(maxScopes)
+         {
+           //Timestamps tick at timestampPeriod nanoseconds
+           VkPhysicalDeviceProperties properties;
+           vkGetPhysicalDeviceProperties(device.GetPhysicalDevice(), &properties);
+           mTimestampPeriod = properties.limits.timestampPeriod;
+       
+           //Only the low valid bits of a timestamp count, the rest are garbage
+           uint32_t count = 0;
+           vkGetPhysicalDeviceQueueFamilyProperties(device.GetPhysicalDevice(), &count, nullptr);
+           std::vector&ltVkQueueFamilyProperties> families(count);
+           vkGetPhysicalDeviceQueueFamilyProperties(device.GetPhysicalDevice(), &count, families.data());
+           uint32_t validBits = queueFamily &lt count ? families[queueFamily].timestampValidBits : 0;
+           mTimestampMask = validBits >= 64 ? UINT64_MAX : (1ull &lt&lt validBits) - 1;
+       
+           //Queue can't write timestamps, so every call does nothing
+           if (validBits == 0)
+           {
+             NL_WARN("Queue family " + std::to_string(queueFamily) + " doesn't support timestamps, gpu profiling is off");
+             return;
+           }
+       
+           //Two queries per scope, one pool per frame
+           mFrames.resize(framesInFlight);
+           for (ProfilerFrame& frame : mFrames)
+           {
+             VkQueryPoolCreateInfo poolInfo{};
+             poolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+             poolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+             poolInfo.queryCount = maxScopes * 2;
+             if (vkCreateQueryPool(device.GetDevice(), &poolInfo, nullptr, &frame.pool) != VK_SUCCESS)
+             {
+               NL_CRITICAL("Failed to create timestamp query pool");
+             }
+           }
+         }
+       
+         /*********************************************************************
+          * @brief: Destroys the profiler's query pools, gpu must be done with
+          *         them
+         *********************************************************************/
+         ComputeProfiler::~ComputeProfiler()
+         {
+           for (ProfilerFrame& frame : mFrames)
+           {
+             vkDestroyQueryPool(mDevice.GetDevice(), frame.pool, nullptr);
+           }
+         }
+       
+         /*********************************************************************
+          * @brief: Moves to the next frame's query pool, reading back the 
+          *         times it held from framesInFlight frames ago, call at the
+          *         start of each frame before any scopes
+          *
+          * @param  commandBuffer: Command buffer the frame starts recording in
+         *********************************************************************/
+         void ComputeProfiler::BeginFrame(VkCommandBuffer commandBuffer)
+         {
+           if (mFrames.empty())
+           {
+             return;
+           }
+       
+           mFrame = (mFrame + 1) % mFrames.size();
+           ProfilerFrame& frame = mFrames[mFrame];
+           Collect(frame);
+       
+           //Pool is reused this frame
+           vkCmdResetQueryPool(commandBuffer, frame.pool, 0, mMaxScopes * 2);
+           frame.scopes.clear();
+           frame.open.clear();
+         }
+       
+         /*********************************************************************
+          * @brief: Starts timing a named scope, scopes can nest
+          *
+          * @param  commandBuffer: Command buffer the timed work is recorded in
+          * @param  name: Name of the scope (stats and trace are grouped by it)
+         *********************************************************************/
+         void ComputeProfiler::BeginScope(VkCommandBuffer commandBuffer, const std::string& name)
+         {
+           if (mFrames.empty())
+           {
+             return;
+           }
+       
+           //Out of queries this frame
+           ProfilerFrame& frame = mFrames[mFrame];
+           if (frame.scopes.size() >= mMaxScopes)
+           {
+             ++mDropped;
+             frame.open.push_back(UINT32_MAX);
+             return;
+           }
+       
+           uint32_t scope = static_cast&ltuint32_t>(frame.scopes.size());
+           frame.scopes.push_back(name);
+           frame.open.push_back(scope);
+           vkCmdWriteTimestamp2(commandBuffer, VK_PIPELINE_STAGE_2_TOP_OF_PIPE_BIT, frame.pool, scope * 2);
+         }
+       
+         /*********************************************************************
+          * @brief: Starts timing a scope named after passed pipeline's shader,
+          *         so stats come out per pipeline
+          *
+          * @param  commandBuffer: Command buffer the timed work is recorded in
+          * @param  pipeline: Pipeline being timed
+         *********************************************************************/
+         void ComputeProfiler::BeginScope(VkCommandBuffer commandBuffer, const ComputePipeline& pipeline)
+         {
+           BeginScope(commandBuffer, pipeline.GetPath());
+         }
+       
+         /*********************************************************************
+          * @brief: Stops timing the most recently started scope
+          *
+          * @param  commandBuffer: Command buffer the timed work is recorded in
+         *********************************************************************/
+         void ComputeProfiler::EndScope(VkCommandBuffer commandBuffer)
+         {
+           if (mFrames.empty() || mFrames[mFrame].open.empty())
+           {
+             return;
+           }
+       
+           ProfilerFrame& frame = mFrames[mFrame];
+           uint32_t scope = frame.open.back();
+           frame.open.pop_back();
+       
+           //Scope was dropped in BeginScope
+           if (scope == UINT32_MAX)
+           {
+             return;
+           }
+       
+           vkCmdWriteTimestamp2(commandBuffer, VK_PIPELINE_STAGE_2_BOTTOM_OF_PIPE_BIT, frame.pool, scope * 2 + 1);
+         }
+       
+         /*********************************************************************
+          * @brief: Reads back a frame's timestamps if the gpu has written 
+          *         them, never waits, scopes that aren't done are dropped
+          *
+          * @param  frame: Frame to read
+         *********************************************************************/
+         void ComputeProfiler::Collect(ProfilerFrame& frame)
+         {
+           if (frame.scopes.empty())
+           {
+             return;
+           }
+       
+           //Each query gives its value then if it is available
+           uint32_t queryCount = static_cast&ltuint32_t>(frame.scopes.size()) * 2;
+           std::vector&ltuint64_t> results(queryCount * 2, 0);
+           vkGetQueryPoolResults(mDevice.GetDevice(), frame.pool, 0, queryCount, results.size() * sizeof(uint64_t), 
+                                 results.data(), sizeof(uint64_t) * 2, 
+                                 VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+       
+           for (uint32_t scope = 0; scope &lt frame.scopes.size(); ++scope)
+           {
+             const uint64_t* start = &results[scope * 4];
+             const uint64_t* end = &results[scope * 4 + 2];
+             if (start[1] == 0 || end[1] == 0)
+             {
+               ++mDropped;
+               continue;
+             }
+       
+             //Convert ticks to nanoseconds
+             uint64_t ticks = ((end[0] & mTimestampMask) - (start[0] & mTimestampMask)) & mTimestampMask;
+             double startNanoseconds = (start[0] & mTimestampMask) * static_cast&ltdouble>(mTimestampPeriod);
+             double nanoseconds = ticks * static_cast&ltdouble>(mTimestampPeriod);
+       
+             //Add to the scope's rolling window of samples
+             ProfilerHistory& history = mHistory[frame.scopes[scope]];
+             float milliseconds = static_cast&ltfloat>(nanoseconds / 1000000.0);
+             if (history.samples.size() &lt ProfilerWindow)
+             {
+               history.samples.push_back(milliseconds);
+             }
+             else
+             {
+               history.samples[history.next] = milliseconds;
+             }
+             history.next = (history.next + 1) % ProfilerWindow;
+       
+             //Keep a bounded trace of events for exporting
+             mTraceEvents.push_back(ProfilerEvent{ frame.scopes[scope], startNanoseconds, nanoseconds });
+             if (mTraceEvents.size() > ProfilerEventLimit)
+             {
+               mTraceEvents.pop_front();
+             }
+           }
+         }
+       
+         /*********************************************************************
+          * @brief: Gets the stats of a scope over its recent samples
+          *
+          * @param  name: Name of the scope (or pipeline shader path)
+          * @return Min, average and 99th percentile gpu time in milliseconds,
+          *         all 0 if the scope has no samples yet
+         *********************************************************************/
+         ComputeProfiler::Stats ComputeProfiler::GetStats(const std::string& name) const
+         {
+           Stats stats{ 0.0f, 0.0f, 0.0f, 0 };
+           auto found = mHistory.find(name);
+           if (found == mHistory.end() || found->second.samples.empty())
+           {
+             return stats;
+           }
+       
+           //Min and average
+           std::vector&ltfloat> samples = found->second.samples;
+           stats.count = static_cast&ltint>(samples.size());
+           stats.min = *std::min_element(samples.begin(), samples.end());
+           for (float sample : samples)
+           {
+             stats.average += sample;
+           }
+           stats.average /= stats.count;
+       
+           //99th percentile
+           size_t p99 = (samples.size() * 99) / 100;
+           std::nth_element(samples.begin(), samples.begin() + p99, samples.end());
+           stats.p99 = samples[p99];
+       
+           return stats;
+         }
+       
+         /*********************************************************************
+          * @brief: Gets how many scopes went untimed, from running out of 
+          *         queries or from the gpu being more than framesInFlight 
+          *         frames behind
+          *
+          * @return Number of dropped scopes
+         *********************************************************************/
+         int ComputeProfiler::GetDroppedCount() const
+         {
+           return mDropped;
+         }
+       
+         /*********************************************************************
+          * @brief: Writes the collected scopes to a Chrome trace file (open 
+          *         in chrome://tracing or Perfetto)
+          *
+          * @param  path: Path of the json file to write
+         *********************************************************************/
+         void ComputeProfiler::WriteChromeTrace(const std::string& path) const
+         {
+           std::ofstream file(path, std::ios::trunc);
+           file &lt&lt "{\"traceEvents\":[";
+       
+           //Trace times are in microseconds, written out in full
+           file &lt&lt std::fixed;
+           bool first = true;
+           for (const ProfilerEvent& event : mTraceEvents)
+           {
+             //Names are shader paths and user scope names, which can have anything in them
+             file &lt&lt (first ? "" : ",") &lt&lt "\n{\"name\":\"" &lt&lt EscapeJson(event.name) 
+                  &lt&lt "\",\"cat\":\"compute\",\"ph\":\"X\",\"pid\":0,\"tid\":0,\"ts\":" &lt&lt event.start / 1000.0
+                  &lt&lt ",\"dur\":" &lt&lt event.duration / 1000.0 &lt&lt "}";
+             first = false;
+           }
+       
+           file &lt&lt "\n]}\n";
+         }
+       
+         /*********************************************************************
+          * @brief: Starts watching this pipeline's shader (and everything it
+          *         includes) on a worker thread, rebuilding it when it 
+          *         changes, call UpdateHotReload once a frame to swap it in
+          *
+          * @param  framesInFlight: Frames the gpu can be behind the cpu, old
+          *                        pipelines live this many frames after a swap
+         *********************************************************************/
+         void ComputePipeline::EnableHotReload(uint32_t framesInFlight)
+         {
+           if (mWatching)
+           {
+             return;
+           }
+       
+           mFramesInFlight = framesInFlight;
+           mWatching = true;
+           mWatcher = std::thread(&ComputePipeline::WatchShader, this);
+         }
+       
+         /*********************************************************************
+          * @brief: Stops watching this pipeline's shader
+         *********************************************************************/
+         void ComputePipeline::DisableHotReload()
+         {
+           if (!mWatching)
+           {
+             return;
+           }
+       
+           mWatching = false;
+           mWatcher.join();
+         }
+       
+         /*********************************************************************
+          * @brief: Swaps in a rebuilt shader if one is ready and destroys old
+          *         ones the gpu is done with, call at a frame boundary before
+          *         recording anything with this pipeline
+          *
+          * @param  frame: Number of the frame about to be recorded, must go 
+          *                up by one each frame
+         *********************************************************************/
+         void ComputePipeline::UpdateHotReload(uint64_t frame)
+         {
+           //Old shaders are safe to destroy once every frame that could use them has retired
+           while (!mRetired.empty() && mRetired.front().frame + mFramesInFlight &lt= frame)
+           {
+             vkDestroyPipeline(mPipelineDevice.GetDevice(), mRetired.front().pipeline, nullptr);
+             vkDestroyShaderModule(mPipelineDevice.GetDevice(), mRetired.front().module, nullptr);
+             mRetired.pop_front();
+           }
+       
+           std::lock_guard&ltstd::mutex> lock(mReloadMutex);
+           if (mPendingReload.pipeline == VK_NULL_HANDLE)
+           {
+             return;
+           }
+       
+           //Swap under the variant lock so GetVariant never builds a variant from the old module after it's retired
+           std::lock_guard&ltstd::mutex> variantLock(mVariantMutex);
+       
+           //Current shader and its variants are retired rather than destroyed, frames in flight still use them
+           mRetired.push_back({ mComputeShaderModule, mComputePipeline, frame });
+           for (const auto& [key, variant] : mVariants)
+           {
+             mRetired.push_back({ VK_NULL_HANDLE, variant, frame });
+           }
+           mVariants.clear();
+       
+           mComputeShaderModule = mPendingReload.module;
+           mComputePipeline = mPendingReload.pipeline;
+           mPendingReload = RetiredShader{};
+           ++mReloadCount;
+       
+           NL_INFO("Hot reloaded compute shader " + mPath);
+         }
+       
+         /*********************************************************************
+          * @brief: Gets how many times this pipeline's shader has been swapped
+          *         for a rebuilt one
+          *
+          * @return Number of reloads
+         *********************************************************************/
+         int ComputePipeline::GetReloadCount() const
+         {
+           return mReloadCount;
+         }
+       
+         /*********************************************************************
+          * @brief: Hot reload thread, polls the shader's source and includes
+          *         and rebuilds the pipeline off the render thread when they
+          *         change
+         *********************************************************************/
+         void ComputePipeline::WatchShader()
+         {
+           uint64_t lastKey = 0;
+           while (mWatching)
+           {
+             //Editors can have the file half written or missing for a moment, so just try again later
+             std::ifstream file{mPath, std::ios::binary};
+             if (file.is_open())
+             {
+               std::string source((std::istreambuf_iterator&ltchar>(file)), std::istreambuf_iterator&ltchar>());
+               uint64_t key = GetSpirvCacheKey(mPath, source);
+       
+               //First pass just learns what's loaded
+               if (lastKey != 0 && key != lastKey)
+               {
+                 RebuildShader(source, key);
+               }
+               lastKey = key;
+             }
+       
+             std::this_thread::sleep_for(sHotReloadInterval);
+           }
+         }
+       
+         /*********************************************************************
+          * @brief: Compiles changed shader source and creates a new pipeline 
+          *         through the pipeline cache, leaving it for UpdateHotReload
+          *         to swap in, the old pipeline stays if anything fails
+          *
+          * @param  source: New code of the shader
+          * @param  key: SPIR-V cache key of the code
+         *********************************************************************/
+         void ComputePipeline::RebuildShader(const std::string& source, uint64_t key)
+         {
+           std::vector&ltuint32_t> computeSPV = CompileGLSLtoSPV(source, EShLangCompute);
+           if (computeSPV.empty())
+           {
+             NL_ERROR("Hot reload of " + mPath + " failed to compile, keeping old shader");
+             return;
+           }
+           WriteSpirvCache(key, computeSPV);
+       
+           //Layout is shared by frames in flight, so a shader that needs a different one waits for a restart
+           if (!IsLayoutCompatible(ReflectShader(computeSPV.data(), computeSPV.size()), mReflection))
+           {
+             NL_WARN("Hot reload of " + mPath + " changed its descriptors or push constants, restart to use it");
+             return;
+           }
+       
+           VkShaderModule module = VK_NULL_HANDLE;
+           CreateShaderModule(mPipelineDevice, computeSPV, &module);
+       
+           VkComputePipelineCreateInfo pipelineCreateInfo = GetPipelineCreateInfo(nullptr, module);
+           VkPipeline pipeline = VK_NULL_HANDLE;
+           if (vkCreateComputePipelines(mPipelineDevice.GetDevice(), mPipelineCache, 1, &pipelineCreateInfo, nullptr, &pipeline) 
+                != VK_SUCCESS)
+           {
+             NL_ERROR("Hot reload of " + mPath + " failed to create pipeline, keeping old shader");
+             vkDestroyShaderModule(mPipelineDevice.GetDevice(), module, nullptr);
+             return;
+           }
+       
+           //Replace any rebuild that never got swapped in
+           std::lock_guard&ltstd::mutex> lock(mReloadMutex);
+           if (mPendingReload.pipeline != VK_NULL_HANDLE)
+           {
+             vkDestroyPipeline(mPipelineDevice.GetDevice(), mPendingReload.pipeline, nullptr);
+             vkDestroyShaderModule(mPipelineDevice.GetDevice(), mPendingReload.module, nullptr);
+           }
+           mPendingReload = { module, pipeline, 0 };
+         }
        }
\ No newline at end of file